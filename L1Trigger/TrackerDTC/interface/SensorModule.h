@@ -3,6 +3,9 @@
 
 #include "DataFormats/DetId/interface/DetId.h"
 
+#include <istream>
+#include <ostream>
+
 namespace trackerDTC {
 
   class Setup;
@@ -11,10 +14,16 @@ namespace trackerDTC {
   class SensorModule {
   public:
     SensorModule(const Setup& setup, const DetId& detId, int dtcId, int modId);
+    // reads sensor module from a module table line written by write()
+    SensorModule(std::istream& stream);
     ~SensorModule() {}
 
     enum Type { BarrelPS, Barrel2S, DiskPS, Disk2S, NumTypes };
 
+    // writes sensor module as one module table line
+    void write(std::ostream& stream) const;
+    // cmssw det id
+    const DetId& detId() const { return detId_; }
     // module type (BarrelPS, Barrel2S, DiskPS, Disk2S)
     Type type() const { return type_; }
     // dtc id [0-215]
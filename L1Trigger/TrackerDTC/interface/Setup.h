@@ -25,8 +25,12 @@
 #include "L1Trigger/TrackerDTC/interface/SensorModule.h"
 
 #include <vector>
+#include <array>
+#include <string>
 #include <set>
 #include <unordered_map>
+#include <memory>
+#include <mutex>
 
 namespace trackerDTC {
 
@@ -35,6 +39,41 @@ namespace trackerDTC {
   // handles 2 pi overflow
   inline double deltaPhi(double lhs, double rhs = 0.) { return reco::deltaPhi(lhs, rhs); }
 
+  /*! \class  trackerDTC::SetupGeometry
+   *  \brief  Geometry, cabling and TTStubAlgorithm derived part of Setup. It is produced by ProducerSetupGeometry
+   *          into SetupGeometryRcd, such that the framework rebuilds it only if geometry, topology, cabling or
+   *          TTStubAlgorithm change, while a change of magnetic field or firmware parameter only recalculates the
+   *          cheap constants of Setup.
+   *  \author Thomas Schuh
+   *  \date   2020, Nov
+   */
+  struct SetupGeometry {
+    // module layout configuration this has been built with, see Setup::geometryConfiguration
+    std::string configuration;
+    // number of tilted layer rings per barrel layer
+    std::vector<double> numTiltedLayerRings;
+    // stub bend window sizes for flat barrel layer in full pitch units
+    std::vector<double> windowSizeBarrelLayers;
+    // stub bend window sizes for tilted barrel layer rings in full pitch units
+    std::vector<std::vector<double>> windowSizeTiltedLayerRings;
+    // stub bend window sizes for endcap disks rings in full pitch units
+    std::vector<std::vector<double>> windowSizeEndcapDisksRings;
+    // maximum stub bend window in half strip units
+    int maxWindowSize;
+    // outer index = module window size, inner index = encoded bend, inner value = decoded bend, for ps modules
+    std::vector<std::vector<double>> encodingsBendPS;
+    // outer index = module window size, inner index = encoded bend, inner value = decoded bend, for 2s modules
+    std::vector<std::vector<double>> encodingsBend2S;
+    // outer index = dtc id in region, inner index = encoded layerId, inner value = decoded layerId
+    std::vector<std::vector<int>> encodingsLayerId;
+    // collection of outer tracker sensor modules
+    std::vector<SensorModule> sensorModules;
+    // collection of outer tracker sensor modules organised in DTCS [0-215][0-71]
+    std::vector<std::vector<SensorModule*>> dtcModules;
+    // hepler to convert Stubs quickly
+    std::unordered_map<DetId, SensorModule*> detIdToSensorModule;
+  };
+
   /*! \class  trackerDTC::Setup
    *  \brief  Class to process and provide run-time constants used by Track Trigger emulators
    *  \author Thomas Schuh
@@ -52,13 +91,30 @@ namespace trackerDTC {
           const edm::ParameterSet& pSetStubAlgorithm,
           const edm::ParameterSet& pSetGeometryConfiguration,
           const edm::ParameterSetID& pSetIdTTStubAlgorithm,
-          const edm::ParameterSetID& pSetIdGeometryConfiguration);
+          const edm::ParameterSetID& pSetIdGeometryConfiguration,
+          const std::shared_ptr<const SetupGeometry>& geometry = nullptr);
+    // standalone construction from a module table written by writeModuleTable, no EventSetup needed
+    Setup(const edm::ParameterSet& iConfig, const std::string& moduleTable);
     ~Setup() {}
 
     // true if tracker geometry and magnetic field supported
     bool configurationSupported() const { return configurationSupported_; }
     // checks current configuration vs input sample configuration
     void checkHistory(const edm::ProcessHistory& processHistory) const;
+    // geometry, cabling and TTStubAlgorithm derived part, reusable for Setups with same geometryConfiguration
+    const std::shared_ptr<const SetupGeometry>& geometry() const { return geometry_; }
+    // module layout parameter the geometry part depends on, Setups with identical string may share it
+    static std::string geometryConfiguration(const edm::ParameterSet& iConfig);
+    // creates geometry part alone, left empty if geometry is not supported
+    static std::unique_ptr<SetupGeometry> produceGeometry(const edm::ParameterSet& iConfig,
+                                                          const TrackerGeometry& trackerGeometry,
+                                                          const TrackerTopology& trackerTopology,
+                                                          const TrackerDetToDTCELinkCablingMap& cablingMap,
+                                                          const StubAlgorithmOfficial& stubAlgorithm,
+                                                          const edm::ParameterSet& pSetStubAlgorithm,
+                                                          const edm::ParameterSet& pSetGeometryConfiguration);
+    // exports all geometry, cabling and TTStubAlgorithm derived constants into a module table
+    void writeModuleTable(const std::string& fileName) const;
     // converts tk layout id into dtc id
     int dtcId(int tklId) const;
     // converts dtci id into tk layout id
@@ -73,12 +129,27 @@ namespace trackerDTC {
     int slot(int dtcId) const;
     // sensor module for det id
     SensorModule* sensorModule(const DetId& detId) const;
-    // TrackerGeometry
+    // TrackerGeometry, nullptr if constructed from module table
     const TrackerGeometry* trackerGeometry() const { return trackerGeometry_; }
-    // TrackerTopology
+    // TrackerTopology, nullptr if constructed from module table
     const TrackerTopology* trackerTopology() const { return trackerTopology_; }
     // returns bit accurate position of a stub from a given tfp identifier region [0-8] channel [0-47]
     GlobalPoint stubPos(bool hybrid, const TTDTC::Frame& frame, int tfpRegion, int tfpChannel) const;
+    // bit accurate positions of all frames of a tfp channel, appends r [cm], phi [rad], z [cm] per frame, 0 for gaps
+    void stubPos(bool hybrid,
+                 const TTDTC::Stream& stream,
+                 int tfpRegion,
+                 int tfpChannel,
+                 std::vector<double>& r,
+                 std::vector<double>& phi,
+                 std::vector<double>& z) const;
+    // bit accurate positions of all frames of a tfp region, channel by channel
+    void stubPos(bool hybrid,
+                 const TTDTC& ttDTC,
+                 int tfpRegion,
+                 std::vector<double>& r,
+                 std::vector<double>& phi,
+                 std::vector<double>& z) const;
     // returns global TTStub position
     GlobalPoint stubPos(const TTStubRef& ttStubRef) const;
     // empty trackerDTC EDProduct
@@ -110,6 +181,8 @@ namespace trackerDTC {
     int numFramesFE() const { return numFramesFE_; }
     // converts GeV in 1/cm
     double invPtToDphi() const { return invPtToDphi_; }
+    // BField used in fw in T
+    double bField() const { return bField_; }
     // region size in rad
     double baseRegion() const { return baseRegion_; }
     // TP eta cut
@@ -204,16 +277,16 @@ namespace trackerDTC {
     // Parameter specifying TTStub algorithm
 
     // number of tilted layer rings per barrel layer
-    double numTiltedLayerRing(int layerId) const { return numTiltedLayerRings_.at(layerId); };
+    double numTiltedLayerRing(int layerId) const { return geometry_->numTiltedLayerRings.at(layerId); };
     // stub bend window sizes for flat barrel layer in full pitch units
-    double windowSizeBarrelLayer(int layerId) const { return windowSizeBarrelLayers_.at(layerId); };
+    double windowSizeBarrelLayer(int layerId) const { return geometry_->windowSizeBarrelLayers.at(layerId); };
     // stub bend window sizes for tilted barrel layer rings in full pitch units
     double windowSizeTiltedLayerRing(int layerId, int ring) const {
-      return windowSizeTiltedLayerRings_.at(layerId).at(ring);
+      return geometry_->windowSizeTiltedLayerRings.at(layerId).at(ring);
     };
     // stub bend window sizes for endcap disks rings in full pitch units
     double windowSizeEndcapDisksRing(int layerId, int ring) const {
-      return windowSizeEndcapDisksRings_.at(layerId).at(ring);
+      return geometry_->windowSizeEndcapDisksRings.at(layerId).at(ring);
     };
     // precision of window sizes in pitch units
     double baseWindowSize() const { return baseWindowSize_; }
@@ -282,7 +355,7 @@ namespace trackerDTC {
     // number of bits for internal stub phi
     int widthPhiDTC() const { return widthPhiDTC_; }
     // sensor modules connected to given dtc id
-    const std::vector<SensorModule*>& dtcModules(int dtcId) const { return dtcModules_.at(dtcId); }
+    const std::vector<SensorModule*>& dtcModules(int dtcId) const { return geometry_->dtcModules.at(dtcId); }
     // index = encoded layerId, inner value = decoded layerId for given tfp channel [0-47]
     const std::vector<int>& encodingLayerId(int tfpChannel) const;
     // total number of output channel
@@ -463,11 +536,37 @@ namespace trackerDTC {
     double lrResidZPS() const { return lrResidZPS_; }
 
   private:
+    // process histories already validated in this job, shared between copies of this Setup
+    struct HistoryCache {
+      std::mutex mutex_;
+      std::set<edm::ProcessHistoryID> validated_;
+    };
+    // reads all configuration parameter
+    Setup(const edm::ParameterSet& iConfig);
     // checks consitency between history and current configuration for a specific module
     void checkHistory(const edm::ProcessHistory&,
                       const edm::pset::Registry*,
                       const std::string&,
                       const edm::ParameterSetID&) const;
+    // constants needed to decode stub positions of one tfp channel, index 0 = endcap, 1 = barrel
+    struct StubPosDecoder {
+      bool hybrid_;
+      bool side_;
+      bool psModule_;
+      double offsetPhi_;
+      // lsb of first position field (hybrid: phi, tmtt: z)
+      std::array<int, 2> lsb_;
+      std::array<int, 2> widthPhi_;
+      std::array<int, 2> widthZ_;
+      std::array<int, 2> widthR_;
+      std::array<double, 2> basePhi_;
+      std::array<double, 2> baseZ_;
+      std::array<double, 2> baseR_;
+    };
+    // collects all constants needed to decode stub positions of given tfp channel, range checks happen here
+    StubPosDecoder stubPosDecoder(bool hybrid, int tfpRegion, int tfpChannel) const;
+    // decodes bit accurate position of a valid frame
+    void stubPos(const StubPosDecoder& decoder, const TTDTC::Frame& frame, double& r, double& phi, double& z) const;
     // dumps pSetHistory where incosistent lines with pSetProcess are highlighted
     std::string dumpDiff(const edm::ParameterSet& pSetHistory, const edm::ParameterSet& pSetProcess) const;
     // check if bField is supported
@@ -476,14 +575,18 @@ namespace trackerDTC {
     void checkGeometry();
     // derive constants
     void calculateConstants();
+    // create geometry, cabling and TTStubAlgorithm derived part
+    void produceGeometry(const edm::ParameterSet& iConfig);
+    // fill geometry, cabling and TTStubAlgorithm derived part, geometry_ has to point to it already
+    void fillGeometry(const edm::ParameterSet& iConfig, SetupGeometry& geometry) const;
     // convert configuration of TTStubAlgorithm
-    void consumeStubAlgorithm();
+    void consumeStubAlgorithm(SetupGeometry& geometry) const;
     // create bend encodings
     void encodeBend(std::vector<std::vector<double>>&, bool) const;
     // create encodingsLayerId
-    void encodeLayerId();
+    void encodeLayerId(SetupGeometry& geometry) const;
     // create sensor modules
-    void produceSensorModules();
+    void produceSensorModules(SetupGeometry& geometry) const;
     // range check of dtc id
     void checkDTCId(int dtcId) const;
     // range check of tklayout id
@@ -493,6 +596,11 @@ namespace trackerDTC {
     // configure TPSelector
     void configureTPSelector();
 
+    // module table identifier
+    static constexpr char moduleTableFormat_[] = "TrackerDTCModuleTable";
+    // module table format version
+    static constexpr int moduleTableVersion_ = 1;
+
     // MagneticField
     const MagneticField* magneticField_;
     // TrackerGeometry
@@ -529,6 +637,8 @@ namespace trackerDTC {
     std::string phGeometryConfiguration_;
     // label of compared TTStubAlgorithm
     std::string phTTStubAlgorithm_;
+    // ids of process histories which passed checkHistory
+    std::shared_ptr<HistoryCache> historyCache_ = std::make_shared<HistoryCache>();
 
     // Common track finding parameter
     edm::ParameterSet pSetTF_;
@@ -823,18 +933,8 @@ namespace trackerDTC {
     // 
     TrackingParticleSelector tpSelectorLoose_;
 
-    // TTStubAlgorithm
-
-    // number of tilted layer rings per barrel layer
-    std::vector<double> numTiltedLayerRings_;
-    // stub bend window sizes for flat barrel layer in full pitch units
-    std::vector<double> windowSizeBarrelLayers_;
-    // stub bend window sizes for tilted barrel layer rings in full pitch units
-    std::vector<std::vector<double>> windowSizeTiltedLayerRings_;
-    // stub bend window sizes for endcap disks rings in full pitch units
-    std::vector<std::vector<double>> windowSizeEndcapDisksRings_;
-    // maximum stub bend window in half strip units
-    int maxWindowSize_;
+    // geometry, cabling and TTStubAlgorithm derived part, shared between copies and rebuilt Setups
+    std::shared_ptr<const SetupGeometry> geometry_;
 
     // common Track finding
 
@@ -907,18 +1007,6 @@ namespace trackerDTC {
     double dtcBaseM_;
     // number of bits for internal stub phi
     int widthPhiDTC_;
-    // outer index = module window size, inner index = encoded bend, inner value = decoded bend, for ps modules
-    std::vector<std::vector<double>> encodingsBendPS_;
-    // outer index = module window size, inner index = encoded bend, inner value = decoded bend, for 2s modules
-    std::vector<std::vector<double>> encodingsBend2S_;
-    // outer index = dtc id in region, inner index = encoded layerId, inner value = decoded layerId
-    std::vector<std::vector<int>> encodingsLayerId_;
-    // collection of outer tracker sensor modules
-    std::vector<SensorModule> sensorModules_;
-    // collection of outer tracker sensor modules organised in DTCS [0-215][0-71]
-    std::vector<std::vector<SensorModule*>> dtcModules_;
-    // hepler to convert Stubs quickly
-    std::unordered_map<DetId, SensorModule*> detIdToSensorModule_;
 
     // GP
 
@@ -1031,6 +1119,7 @@ namespace trackerDTC {
 
 }  // namespace trackerDTC
 
+EVENTSETUP_DATA_DEFAULT_RECORD(trackerDTC::SetupGeometry, trackerDTC::SetupGeometryRcd);
 EVENTSETUP_DATA_DEFAULT_RECORD(trackerDTC::Setup, trackerDTC::SetupRcd);
 
 #endif
\ No newline at end of file
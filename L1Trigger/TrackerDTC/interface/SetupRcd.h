@@ -15,6 +15,16 @@
 namespace trackerDTC {
 
   typedef boost::mpl::vector<TrackerDigiGeometryRecord,
+                             TrackerTopologyRcd,
+                             IdealGeometryRecord,
+                             TrackerDetToDTCELinkCablingMapRcd,
+                             TTStubAlgorithmRecord>
+      RcdsGeometry;
+
+  class SetupGeometryRcd : public edm::eventsetup::DependentRecordImplementation<SetupGeometryRcd, RcdsGeometry> {};
+
+  typedef boost::mpl::vector<SetupGeometryRcd,
+                             TrackerDigiGeometryRecord,
                              TrackerTopologyRcd,
                              IdealMagneticFieldRecord,
                              IdealGeometryRecord,
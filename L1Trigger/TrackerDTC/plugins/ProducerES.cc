@@ -7,6 +7,7 @@
 #include "L1Trigger/TrackerDTC/interface/Setup.h"
 
 #include <memory>
+#include <string>
 
 using namespace std;
 using namespace edm;
@@ -26,22 +27,27 @@ namespace trackerDTC {
 
   private:
     const ParameterSet iConfig_;
+    // if not empty, module table of produced setup is exported into this file
+    const string moduleTableFile_;
     ESGetToken<StubAlgorithm, TTStubAlgorithmRecord> getTokenTTStubAlgorithm_;
     ESGetToken<MagneticField, IdealMagneticFieldRecord> getTokenMagneticField_;
     ESGetToken<TrackerGeometry, TrackerDigiGeometryRecord> getTokenTrackerGeometry_;
     ESGetToken<TrackerTopology, TrackerTopologyRcd> getTokenTrackerTopology_;
     ESGetToken<TrackerDetToDTCELinkCablingMap, TrackerDetToDTCELinkCablingMapRcd> getTokenCablingMap_;
     ESGetToken<DDCompactView, IdealGeometryRecord> getTokenGeometryConfiguration_;
+    ESGetToken<SetupGeometry, SetupGeometryRcd> getTokenSetupGeometry_;
   };
 
-  ProducerES::ProducerES(const ParameterSet& iConfig) : iConfig_(iConfig) {
+  ProducerES::ProducerES(const ParameterSet& iConfig)
+      : iConfig_(iConfig), moduleTableFile_(iConfig.getUntrackedParameter<string>("ModuleTableFile", "")) {
     setWhatProduced(this)
         .setConsumes(getTokenTTStubAlgorithm_)
         .setConsumes(getTokenMagneticField_)
         .setConsumes(getTokenTrackerGeometry_)
         .setConsumes(getTokenTrackerTopology_)
         .setConsumes(getTokenCablingMap_)
-        .setConsumes(getTokenGeometryConfiguration_);
+        .setConsumes(getTokenGeometryConfiguration_)
+        .setConsumes(getTokenSetupGeometry_);
   }
 
   unique_ptr<Setup> ProducerES::produce(const SetupRcd& setupRcd) {
@@ -57,16 +63,24 @@ namespace trackerDTC {
         *dynamic_cast<const StubAlgorithmOfficial*>(&setupRcd.get(getTokenTTStubAlgorithm_));
     const ParameterSet& pSetStubAlgorithm = getParameterSet(handleStubAlgorithm.description()->pid_);
     const ParameterSet& pSetGeometryConfiguration = getParameterSet(handleGeometryConfiguration.description()->pid_);
-    return make_unique<Setup>(iConfig_,
-                              magneticField,
-                              trackerGeometry,
-                              trackerTopology,
-                              cablingMap,
-                              stubAlgoritm,
-                              pSetStubAlgorithm,
-                              pSetGeometryConfiguration,
-                              pSetIdTTStubAlgorithm,
-                              pSetIdGeometryConfiguration);
+    // geometry part is owned by the EventSetup, SetupRcd depends on SetupGeometryRcd and so never outlives it
+    const SetupGeometry& setupGeometry = setupRcd.get(getTokenSetupGeometry_);
+    const shared_ptr<const SetupGeometry> geometry(shared_ptr<const SetupGeometry>(), &setupGeometry);
+    auto setup = make_unique<Setup>(iConfig_,
+                                    magneticField,
+                                    trackerGeometry,
+                                    trackerTopology,
+                                    cablingMap,
+                                    stubAlgoritm,
+                                    pSetStubAlgorithm,
+                                    pSetGeometryConfiguration,
+                                    pSetIdTTStubAlgorithm,
+                                    pSetIdGeometryConfiguration,
+                                    geometry);
+    // export module table to allow standalone Setup construction without EventSetup
+    if (!moduleTableFile_.empty())
+      setup->writeModuleTable(moduleTableFile_);
+    return setup;
   }
 
 }  // namespace trackerDTC
@@ -0,0 +1,66 @@
+#include "FWCore/Framework/interface/ESProducer.h"
+#include "FWCore/Framework/interface/ESHandle.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/Utilities/interface/ESGetToken.h"
+#include "L1Trigger/TrackerDTC/interface/Setup.h"
+
+#include <memory>
+
+using namespace std;
+using namespace edm;
+
+namespace trackerDTC {
+
+  /*! \class  trackerDTC::ProducerSetupGeometry
+   *  \brief  Class to produce the geometry, cabling and TTStubAlgorithm derived part of Setup, which the framework
+   *          only rebuilds if one of the records in SetupGeometryRcd changes
+   *  \author Thomas Schuh
+   *  \date   2020, Nov
+   */
+  class ProducerSetupGeometry : public ESProducer {
+  public:
+    ProducerSetupGeometry(const ParameterSet& iConfig);
+    ~ProducerSetupGeometry() override {}
+    unique_ptr<SetupGeometry> produce(const SetupGeometryRcd& setupGeometryRcd);
+
+  private:
+    const ParameterSet iConfig_;
+    ESGetToken<StubAlgorithm, TTStubAlgorithmRecord> getTokenTTStubAlgorithm_;
+    ESGetToken<TrackerGeometry, TrackerDigiGeometryRecord> getTokenTrackerGeometry_;
+    ESGetToken<TrackerTopology, TrackerTopologyRcd> getTokenTrackerTopology_;
+    ESGetToken<TrackerDetToDTCELinkCablingMap, TrackerDetToDTCELinkCablingMapRcd> getTokenCablingMap_;
+    ESGetToken<DDCompactView, IdealGeometryRecord> getTokenGeometryConfiguration_;
+  };
+
+  ProducerSetupGeometry::ProducerSetupGeometry(const ParameterSet& iConfig) : iConfig_(iConfig) {
+    setWhatProduced(this)
+        .setConsumes(getTokenTTStubAlgorithm_)
+        .setConsumes(getTokenTrackerGeometry_)
+        .setConsumes(getTokenTrackerTopology_)
+        .setConsumes(getTokenCablingMap_)
+        .setConsumes(getTokenGeometryConfiguration_);
+  }
+
+  unique_ptr<SetupGeometry> ProducerSetupGeometry::produce(const SetupGeometryRcd& setupGeometryRcd) {
+    const TrackerGeometry& trackerGeometry = setupGeometryRcd.get(getTokenTrackerGeometry_);
+    const TrackerTopology& trackerTopology = setupGeometryRcd.get(getTokenTrackerTopology_);
+    const TrackerDetToDTCELinkCablingMap& cablingMap = setupGeometryRcd.get(getTokenCablingMap_);
+    const ESHandle<StubAlgorithm> handleStubAlgorithm = setupGeometryRcd.getHandle(getTokenTTStubAlgorithm_);
+    const ESHandle<DDCompactView> handleGeometryConfiguration =
+        setupGeometryRcd.getHandle(getTokenGeometryConfiguration_);
+    const StubAlgorithmOfficial& stubAlgoritm =
+        *dynamic_cast<const StubAlgorithmOfficial*>(&setupGeometryRcd.get(getTokenTTStubAlgorithm_));
+    const ParameterSet& pSetStubAlgorithm = getParameterSet(handleStubAlgorithm.description()->pid_);
+    const ParameterSet& pSetGeometryConfiguration = getParameterSet(handleGeometryConfiguration.description()->pid_);
+    return Setup::produceGeometry(iConfig_,
+                                  trackerGeometry,
+                                  trackerTopology,
+                                  cablingMap,
+                                  stubAlgoritm,
+                                  pSetStubAlgorithm,
+                                  pSetGeometryConfiguration);
+  }
+
+}  // namespace trackerDTC
+
+DEFINE_FWK_EVENTSETUP_MODULE(trackerDTC::ProducerSetupGeometry);
@@ -3,4 +3,7 @@ import FWCore.ParameterSet.Config as cms
 from L1Trigger.TrackerDTC.Analyzer_cfi import TrackerDTCAnalyzer_params
 from L1Trigger.TrackerDTC.ProducerED_cfi import TrackerDTCProducer_params
 
-TrackerDTCAnalyzer = cms.EDAnalyzer('trackerDTC::Analyzer', TrackerDTCAnalyzer_params, TrackerDTCProducer_params)
\ No newline at end of file
+TrackerDTCAnalyzer = cms.EDAnalyzer('trackerDTC::Analyzer', TrackerDTCAnalyzer_params, TrackerDTCProducer_params)
+from L1Trigger.TrackerDTC.ProducerES_cfi import TrackTrigger_params
+
+TrackerDTCAnalyzerModuleTable = cms.EDAnalyzer('trackerDTC::AnalyzerModuleTable', TrackTrigger_params, ModuleTableFile = cms.string('TrackerDTCModuleTableTest.txt'))
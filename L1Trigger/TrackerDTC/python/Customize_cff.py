@@ -11,4 +11,7 @@ def analyzerUseTMTT(process):
     from L1Trigger.TrackerDTC.ProducerED_cfi import TrackerDTCProducer_params
     TrackerDTCProducer_params.UseHybrid = cms.bool( False )
     process.TrackerDTCAnalyzer = cms.EDAnalyzer('trackerDTC::Analyzer', TrackerDTCAnalyzer_params, TrackerDTCProducer_params)
-    return process
\ No newline at end of file
+    return process
+def setupWriteModuleTable(process, fileName = 'TrackerDTCModuleTable.txt'):
+    process.TrackTriggerSetup.ModuleTableFile = cms.untracked.string( fileName )
+    return process
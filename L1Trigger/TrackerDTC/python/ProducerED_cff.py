@@ -7,6 +7,6 @@ import FWCore.ParameterSet.Config as cms
 #=== Import default values for all parameters & define EDProducer.
 
 from L1Trigger.TrackerDTC.ProducerED_cfi import TrackerDTCProducer_params
-from L1Trigger.TrackerDTC.ProducerES_cff import TrackTriggerSetup
+from L1Trigger.TrackerDTC.ProducerES_cff import TrackTriggerSetup, TrackTriggerSetupGeometry
 
 TrackerDTCProducer = cms.EDProducer('trackerDTC::ProducerED', TrackerDTCProducer_params)
\ No newline at end of file
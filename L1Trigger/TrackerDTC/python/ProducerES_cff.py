@@ -2,4 +2,5 @@ import FWCore.ParameterSet.Config as cms
 
 from L1Trigger.TrackerDTC.ProducerES_cfi import TrackTrigger_params
 
-TrackTriggerSetup = cms.ESProducer("trackerDTC::ProducerES", TrackTrigger_params)
\ No newline at end of file
+TrackTriggerSetup = cms.ESProducer("trackerDTC::ProducerES", TrackTrigger_params)
+TrackTriggerSetupGeometry = cms.ESProducer("trackerDTC::ProducerSetupGeometry", TrackTrigger_params)
@@ -1,4 +1,5 @@
 #include "FWCore/Utilities/interface/typelookup.h"
 #include "L1Trigger/TrackerDTC/interface/Setup.h"
 
-TYPELOOKUP_DATA_REG(trackerDTC::Setup);
\ No newline at end of file
+TYPELOOKUP_DATA_REG(trackerDTC::Setup);
+TYPELOOKUP_DATA_REG(trackerDTC::SetupGeometry);
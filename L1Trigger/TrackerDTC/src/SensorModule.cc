@@ -6,6 +6,8 @@
 #include <algorithm>
 #include <iterator>
 #include <vector>
+#include <istream>
+#include <ostream>
 
 using namespace std;
 using namespace edm;
@@ -117,4 +119,24 @@ namespace trackerDTC {
     encodedLayerId_ = distance(encodingLayerId.begin(), pos);
   }
 
-}  // namespace trackerDTC
\ No newline at end of file
+  // reads sensor module from a module table line written by write()
+  SensorModule::SensorModule(istream& stream) {
+    unsigned int rawId;
+    int type;
+    stream >> rawId >> dtcId_ >> modId_ >> side_ >> barrel_ >> psModule_ >> flipped_ >> signRow_ >> signCol_ >>
+        signBend_ >> numColumns_ >> numRows_ >> layerId_ >> r_ >> phi_ >> z_ >> sep_ >> pitchRow_ >> pitchCol_ >>
+        tilt_ >> sin_ >> cos_ >> type >> encodedR_ >> encodedLayerId_ >> offsetR_ >> offsetZ_ >> windowSize_;
+    detId_ = DetId(rawId);
+    type_ = static_cast<Type>(type);
+  }
+
+  // writes sensor module as one module table line
+  void SensorModule::write(ostream& stream) const {
+    stream << detId_.rawId() << " " << dtcId_ << " " << modId_ << " " << side_ << " " << barrel_ << " " << psModule_
+           << " " << flipped_ << " " << signRow_ << " " << signCol_ << " " << signBend_ << " " << numColumns_ << " "
+           << numRows_ << " " << layerId_ << " " << r_ << " " << phi_ << " " << z_ << " " << sep_ << " " << pitchRow_
+           << " " << pitchCol_ << " " << tilt_ << " " << sin_ << " " << cos_ << " " << type_ << " " << encodedR_ << " "
+           << encodedLayerId_ << " " << offsetR_ << " " << offsetZ_ << " " << windowSize_ << endl;
+  }
+
+}  // namespace trackerDTC
@@ -10,31 +10,24 @@
 #include <unordered_map>
 #include <string>
 #include <sstream>
+#include <fstream>
+#include <limits>
+#include <mutex>
 
 using namespace std;
 using namespace edm;
 
 namespace trackerDTC {
 
-  Setup::Setup(const ParameterSet& iConfig,
-               const MagneticField& magneticField,
-               const TrackerGeometry& trackerGeometry,
-               const TrackerTopology& trackerTopology,
-               const TrackerDetToDTCELinkCablingMap& cablingMap,
-               const StubAlgorithmOfficial& stubAlgorithm,
-               const ParameterSet& pSetStubAlgorithm,
-               const ParameterSet& pSetGeometryConfiguration,
-               const ParameterSetID& pSetIdTTStubAlgorithm,
-               const ParameterSetID& pSetIdGeometryConfiguration)
-      : magneticField_(&magneticField),
-        trackerGeometry_(&trackerGeometry),
-        trackerTopology_(&trackerTopology),
-        cablingMap_(&cablingMap),
-        stubAlgorithm_(&stubAlgorithm),
-        pSetSA_(&pSetStubAlgorithm),
-        pSetGC_(&pSetGeometryConfiguration),
-        pSetIdTTStubAlgorithm_(pSetIdTTStubAlgorithm),
-        pSetIdGeometryConfiguration_(pSetIdGeometryConfiguration),
+  // reads all configuration parameter
+  Setup::Setup(const ParameterSet& iConfig)
+      : magneticField_(nullptr),
+        trackerGeometry_(nullptr),
+        trackerTopology_(nullptr),
+        cablingMap_(nullptr),
+        stubAlgorithm_(nullptr),
+        pSetSA_(nullptr),
+        pSetGC_(nullptr),
         // Parameter to check if configured Tracker Geometry is supported
         pSetSG_(iConfig.getParameter<ParameterSet>("SupportedGeometry")),
         sgXMLLabel_(pSetSG_.getParameter<string>("XMLLabel")),
@@ -207,6 +200,29 @@ namespace trackerDTC {
         lrResidPhi_(pSetLR_.getParameter<double>("ResidPhi")),
         lrResidZ2S_(pSetLR_.getParameter<double>("ResidZ2S")),
         lrResidZPS_(pSetLR_.getParameter<double>("ResidZPS")) {
+  }
+
+  Setup::Setup(const ParameterSet& iConfig,
+               const MagneticField& magneticField,
+               const TrackerGeometry& trackerGeometry,
+               const TrackerTopology& trackerTopology,
+               const TrackerDetToDTCELinkCablingMap& cablingMap,
+               const StubAlgorithmOfficial& stubAlgorithm,
+               const ParameterSet& pSetStubAlgorithm,
+               const ParameterSet& pSetGeometryConfiguration,
+               const ParameterSetID& pSetIdTTStubAlgorithm,
+               const ParameterSetID& pSetIdGeometryConfiguration,
+               const shared_ptr<const SetupGeometry>& geometry)
+      : Setup(iConfig) {
+    magneticField_ = &magneticField;
+    trackerGeometry_ = &trackerGeometry;
+    trackerTopology_ = &trackerTopology;
+    cablingMap_ = &cablingMap;
+    stubAlgorithm_ = &stubAlgorithm;
+    pSetSA_ = &pSetStubAlgorithm;
+    pSetGC_ = &pSetGeometryConfiguration;
+    pSetIdTTStubAlgorithm_ = pSetIdTTStubAlgorithm;
+    pSetIdGeometryConfiguration_ = pSetIdGeometryConfiguration;
     configurationSupported_ = true;
     // check if bField is supported
     checkMagneticField();
@@ -216,29 +232,233 @@ namespace trackerDTC {
       return;
     // derive constants
     calculateConstants();
+    // reuse given geometry part if built from same module layout configuration, otherwise create it
+    if (geometry && geometry->configuration == geometryConfiguration(iConfig))
+      geometry_ = geometry;
+    else
+      produceGeometry(iConfig);
+    // configure TPSelector
+    configureTPSelector();
+  }
+
+  // module layout parameter the geometry part depends on, Setups with identical string may share it
+  string Setup::geometryConfiguration(const ParameterSet& iConfig) {
+    const ParameterSet& pSetDTC = iConfig.getParameter<ParameterSet>("DTC");
+    const ParameterSet& pSetFE = iConfig.getParameter<ParameterSet>("FrontEnd");
+    stringstream ss;
+    ss.precision(numeric_limits<double>::max_digits10);
+    ss << iConfig.getParameter<ParameterSet>("Hybrid").dump() << endl;
+    for (const char* label : {"NumRegions",
+                              "NumATCASlots",
+                              "NumDTCsPerRegion",
+                              "NumModulesPerDTC",
+                              "OffsetDetIdTP",
+                              "OffsetLayerDisks",
+                              "OffsetLayerId"})
+      ss << label << " " << pSetDTC.getParameter<int>(label) << endl;
+    ss << "BaseWindowSize " << pSetFE.getParameter<double>("BaseWindowSize") << endl;
+    return ss.str();
+  }
+
+  // creates geometry part alone, left empty if geometry is not supported
+  unique_ptr<SetupGeometry> Setup::produceGeometry(const ParameterSet& iConfig,
+                                                   const TrackerGeometry& trackerGeometry,
+                                                   const TrackerTopology& trackerTopology,
+                                                   const TrackerDetToDTCELinkCablingMap& cablingMap,
+                                                   const StubAlgorithmOfficial& stubAlgorithm,
+                                                   const ParameterSet& pSetStubAlgorithm,
+                                                   const ParameterSet& pSetGeometryConfiguration) {
+    auto geometry = make_unique<SetupGeometry>();
+    Setup setup(iConfig);
+    setup.trackerGeometry_ = &trackerGeometry;
+    setup.trackerTopology_ = &trackerTopology;
+    setup.cablingMap_ = &cablingMap;
+    setup.stubAlgorithm_ = &stubAlgorithm;
+    setup.pSetSA_ = &pSetStubAlgorithm;
+    setup.pSetGC_ = &pSetGeometryConfiguration;
+    setup.configurationSupported_ = true;
+    setup.checkGeometry();
+    if (!setup.configurationSupported_)
+      return geometry;
+    setup.calculateConstants();
+    // SensorModule construction reads from geometry part under construction, which is owned by the caller
+    setup.geometry_ = shared_ptr<const SetupGeometry>(shared_ptr<const SetupGeometry>(), geometry.get());
+    setup.fillGeometry(iConfig, *geometry);
+    return geometry;
+  }
+
+  // create geometry, cabling and TTStubAlgorithm derived part
+  void Setup::produceGeometry(const ParameterSet& iConfig) {
+    shared_ptr<SetupGeometry> geometry = make_shared<SetupGeometry>();
+    // SensorModule construction already reads from geometry part under construction
+    geometry_ = geometry;
+    fillGeometry(iConfig, *geometry);
+  }
+
+  // fill geometry, cabling and TTStubAlgorithm derived part, geometry_ has to point to it already
+  void Setup::fillGeometry(const ParameterSet& iConfig, SetupGeometry& geometry) const {
+    geometry.configuration = geometryConfiguration(iConfig);
     // convert configuration of TTStubAlgorithm
-    consumeStubAlgorithm();
+    consumeStubAlgorithm(geometry);
     // create all possible encodingsBend
-    encodingsBendPS_.reserve(maxWindowSize_ + 1);
-    encodingsBend2S_.reserve(maxWindowSize_ + 1);
-    encodeBend(encodingsBendPS_, true);
-    encodeBend(encodingsBend2S_, false);
+    geometry.encodingsBendPS.reserve(geometry.maxWindowSize + 1);
+    geometry.encodingsBend2S.reserve(geometry.maxWindowSize + 1);
+    encodeBend(geometry.encodingsBendPS, true);
+    encodeBend(geometry.encodingsBend2S, false);
     // create encodingsLayerId
-    encodingsLayerId_.reserve(numDTCsPerRegion_);
-    encodeLayerId();
+    geometry.encodingsLayerId.reserve(numDTCsPerRegion_);
+    encodeLayerId(geometry);
     // create sensor modules
-    produceSensorModules();
+    produceSensorModules(geometry);
+  }
+
+  // standalone construction from a module table written by writeModuleTable, no EventSetup needed
+  Setup::Setup(const ParameterSet& iConfig, const string& moduleTable) : Setup(iConfig) {
+    ifstream stream(moduleTable);
+    if (!stream.is_open()) {
+      cms::Exception exception("FileOpenError");
+      exception << "Could not open module table " << moduleTable << ".";
+      exception.addContext("trackerDTC::Setup::Setup");
+      throw exception;
+    }
+    auto read = [&stream](auto& values) {
+      size_t size(0);
+      stream >> size;
+      values.resize(size);
+      for (auto& value : values)
+        stream >> value;
+    };
+    auto readNested = [&stream, &read](auto& valuess) {
+      size_t size(0);
+      stream >> size;
+      valuess.resize(size);
+      for (auto& values : valuess)
+        read(values);
+    };
+    string format;
+    int version(-1);
+    int numDTCs(-1);
+    int numModulesPerDTC(-1);
+    stream >> format >> version >> configurationSupported_ >> numDTCs >> numModulesPerDTC;
+    if (format != moduleTableFormat_ || version != moduleTableVersion_) {
+      cms::Exception exception("FileReadError");
+      exception << moduleTable << " is not a module table of version " << moduleTableVersion_ << ".";
+      exception.addContext("trackerDTC::Setup::Setup");
+      throw exception;
+    }
+    if (!configurationSupported_)
+      return;
+    // derive constants
+    calculateConstants();
+    if (numDTCs != numDTCs_ || numModulesPerDTC != numModulesPerDTC_) {
+      cms::Exception exception("BadConfiguration");
+      exception << "Module table " << moduleTable << " has been written for " << numDTCs << " DTCs with "
+                << numModulesPerDTC << " modules each, configuration uses " << numDTCs_ << " DTCs with "
+                << numModulesPerDTC_ << " modules each.";
+      exception.addContext("trackerDTC::Setup::Setup");
+      throw exception;
+    }
+    shared_ptr<SetupGeometry> geometry = make_shared<SetupGeometry>();
+    geometry_ = geometry;
+    geometry->configuration = geometryConfiguration(iConfig);
+    // converted configuration of TTStubAlgorithm
+    read(geometry->numTiltedLayerRings);
+    read(geometry->windowSizeBarrelLayers);
+    readNested(geometry->windowSizeTiltedLayerRings);
+    readNested(geometry->windowSizeEndcapDisksRings);
+    stream >> geometry->maxWindowSize;
+    // bend and layerId encodings
+    readNested(geometry->encodingsBendPS);
+    readNested(geometry->encodingsBend2S);
+    readNested(geometry->encodingsLayerId);
+    // sensor modules, reserved upfront since dtcModules and detIdToSensorModule point into sensorModules
+    int numSensorModules(-1);
+    stream >> numSensorModules;
+    if (numSensorModules < 0 || numSensorModules > numModules_) {
+      cms::Exception exception("FileReadError");
+      exception << "Module table " << moduleTable << " lists " << numSensorModules << " modules, expected 0 to "
+                << numModules_ << ".";
+      exception.addContext("trackerDTC::Setup::Setup");
+      throw exception;
+    }
+    geometry->sensorModules.reserve(numModules_);
+    geometry->dtcModules = vector<vector<SensorModule*>>(numDTCs_);
+    for (vector<SensorModule*>& dtcModules : geometry->dtcModules)
+      dtcModules.reserve(numModulesPerDTC_);
+    auto checkStream = [&stream, &moduleTable]() {
+      if (!stream.fail())
+        return;
+      cms::Exception exception("FileReadError");
+      exception << "Module table " << moduleTable << " is truncated or corrupted.";
+      exception.addContext("trackerDTC::Setup::Setup");
+      throw exception;
+    };
+    for (int i = 0; i < numSensorModules; i++) {
+      geometry->sensorModules.emplace_back(stream);
+      // a failed read leaves the module uninitialised, check before it is used
+      checkStream();
+      SensorModule* sensorModule = &geometry->sensorModules.back();
+      checkDTCId(sensorModule->dtcId());
+      geometry->detIdToSensorModule.emplace(sensorModule->detId(), sensorModule);
+      geometry->dtcModules[sensorModule->dtcId()].push_back(sensorModule);
+    }
+    for (vector<SensorModule*>& dtcModules : geometry->dtcModules)
+      dtcModules.shrink_to_fit();
     // configure TPSelector
     configureTPSelector();
   }
 
-  // checks current configuration vs input sample configuration
+  // exports all geometry, cabling and TTStubAlgorithm derived constants into a module table
+  void Setup::writeModuleTable(const string& fileName) const {
+    ofstream stream(fileName);
+    if (!stream.is_open()) {
+      cms::Exception exception("FileOpenError");
+      exception << "Could not open module table " << fileName << ".";
+      exception.addContext("trackerDTC::Setup::writeModuleTable");
+      throw exception;
+    }
+    // full precision to reproduce all doubles bit by bit
+    stream.precision(numeric_limits<double>::max_digits10);
+    auto write = [&stream](const auto& values) {
+      stream << values.size();
+      for (const auto& value : values)
+        stream << " " << value;
+      stream << endl;
+    };
+    auto writeNested = [&stream, &write](const auto& valuess) {
+      stream << valuess.size() << endl;
+      for (const auto& values : valuess)
+        write(values);
+    };
+    stream << moduleTableFormat_ << " " << moduleTableVersion_ << endl;
+    stream << configurationSupported_ << " " << numDTCs_ << " " << numModulesPerDTC_ << endl;
+    if (!configurationSupported_)
+      return;
+    write(geometry_->numTiltedLayerRings);
+    write(geometry_->windowSizeBarrelLayers);
+    writeNested(geometry_->windowSizeTiltedLayerRings);
+    writeNested(geometry_->windowSizeEndcapDisksRings);
+    stream << geometry_->maxWindowSize << endl;
+    writeNested(geometry_->encodingsBendPS);
+    writeNested(geometry_->encodingsBend2S);
+    writeNested(geometry_->encodingsLayerId);
+    stream << geometry_->sensorModules.size() << endl;
+    for (const SensorModule& sensorModule : geometry_->sensorModules)
+      sensorModule.write(stream);
+  }
+
+  // checks current configuration vs input sample configuration, each distinct history is checked only once per job
   void Setup::checkHistory(const ProcessHistory& processHistory) const {
+    const ProcessHistoryID& id = processHistory.id();
+    lock_guard<mutex> lock(historyCache_->mutex_);
+    if (historyCache_->validated_.count(id))
+      return;
     const pset::Registry* psetRegistry = pset::Registry::instance();
     // check used TTStubAlgorithm in input producer
     checkHistory(processHistory, psetRegistry, phTTStubAlgorithm_, pSetIdTTStubAlgorithm_);
     // check used GeometryConfiguration in input producer
     checkHistory(processHistory, psetRegistry, phGeometryConfiguration_, pSetIdGeometryConfiguration_);
+    historyCache_->validated_.insert(id);
   }
 
   // checks consitency between history and current configuration for a specific module
@@ -246,31 +466,42 @@ namespace trackerDTC {
                            const pset::Registry* pr,
                            const string& label,
                            const ParameterSetID& pSetId) const {
-    vector<pair<string, ParameterSet>> pSets;
-    pSets.reserve(ph.size());
+    // compare pset ids only, psets are copied and dumped only if an inconsistency has been found
+    bool found(false);
+    bool consistent(true);
     for (const ProcessConfiguration& pc : ph) {
       const ParameterSet* pSet = pr->getMapped(pc.parameterSetID());
-      if (pSet && pSet->exists(label))
-        pSets.emplace_back(pc.processName(), pSet->getParameterSet(label));
+      if (!pSet || !pSet->exists(label))
+        continue;
+      found = true;
+      if (pSet->getParameterSet(label).id() != pSetId) {
+        consistent = false;
+        break;
+      }
     }
-    if (pSets.empty()) {
+    if (!found) {
       cms::Exception exception("BadConfiguration");
       exception << label << " not found in process history.";
       exception.addContext("tt::Setup::checkHistory");
       throw exception;
     }
-    auto consistent = [&pSetId](const pair<string, ParameterSet>& p) { return p.second.id() == pSetId; };
-    if (!all_of(pSets.begin(), pSets.end(), consistent)) {
-      const ParameterSet& pSetProcess = getParameterSet(pSetId);
-      cms::Exception exception("BadConfiguration");
-      exception.addContext("tt::Setup::checkHistory");
-      exception << label << " inconsistent with History." << endl;
-      exception << "Current Configuration:" << endl << pSetProcess.dump() << endl;
-      for (const pair<string, ParameterSet>& p : pSets)
-        if (!consistent(p))
-          exception << "Process " << p.first << " Configuration:" << endl << dumpDiff(p.second, pSetProcess) << endl;
-      throw exception;
+    if (consistent)
+      return;
+    vector<pair<string, ParameterSet>> pSets;
+    pSets.reserve(ph.size());
+    for (const ProcessConfiguration& pc : ph) {
+      const ParameterSet* pSet = pr->getMapped(pc.parameterSetID());
+      if (pSet && pSet->exists(label) && pSet->getParameterSet(label).id() != pSetId)
+        pSets.emplace_back(pc.processName(), pSet->getParameterSet(label));
     }
+    const ParameterSet& pSetProcess = getParameterSet(pSetId);
+    cms::Exception exception("BadConfiguration");
+    exception.addContext("tt::Setup::checkHistory");
+    exception << label << " inconsistent with History." << endl;
+    exception << "Current Configuration:" << endl << pSetProcess.dump() << endl;
+    for (const pair<string, ParameterSet>& p : pSets)
+      exception << "Process " << p.first << " Configuration:" << endl << dumpDiff(p.second, pSetProcess) << endl;
+    throw exception;
   }
 
   // dumps pSetHistory where incosistent lines with pSetProcess are highlighted
@@ -335,8 +566,8 @@ namespace trackerDTC {
 
   // sensor module for det id
   SensorModule* Setup::sensorModule(const DetId& detId) const {
-    const auto it = detIdToSensorModule_.find(detId);
-    if (it == detIdToSensorModule_.end()) {
+    const auto it = geometry_->detIdToSensorModule.find(detId);
+    if (it == geometry_->detIdToSensorModule.end()) {
       cms::Exception exception("NullPtr");
       exception << "Unknown DetId used.";
       exception.addContext("tt::Setup::sensorModule");
@@ -347,14 +578,14 @@ namespace trackerDTC {
 
   // index = encoded bend, value = decoded bend for given window size and module type
   const vector<double>& Setup::encodingBend(int windowSize, bool psModule) const {
-    const vector<vector<double>>& encodingsBend = psModule ? encodingsBendPS_ : encodingsBend2S_;
+    const vector<vector<double>>& encodingsBend = psModule ? geometry_->encodingsBendPS : geometry_->encodingsBend2S;
     return encodingsBend.at(windowSize);
   }
 
   // index = encoded layerId, inner value = decoded layerId for given dtcId or tfp channel
   const vector<int>& Setup::encodingLayerId(int dtcId) const {
     const int index = dtcId % numDTCsPerRegion_;
-    return encodingsLayerId_.at(index);
+    return geometry_->encodingsLayerId.at(index);
   }
 
   // check if bField is supported
@@ -392,27 +623,28 @@ namespace trackerDTC {
   }
 
   // convert configuration of TTStubAlgorithm
-  void Setup::consumeStubAlgorithm() {
-    numTiltedLayerRings_ = pSetSA_->getParameter<vector<double>>("NTiltedRings");
-    windowSizeBarrelLayers_ = pSetSA_->getParameter<vector<double>>("BarrelCut");
+  void Setup::consumeStubAlgorithm(SetupGeometry& geometry) const {
+    geometry.numTiltedLayerRings = pSetSA_->getParameter<vector<double>>("NTiltedRings");
+    geometry.windowSizeBarrelLayers = pSetSA_->getParameter<vector<double>>("BarrelCut");
     const auto& pSetsTiltedLayer = pSetSA_->getParameter<vector<ParameterSet>>("TiltedBarrelCutSet");
     const auto& pSetsEncapDisks = pSetSA_->getParameter<vector<ParameterSet>>("EndcapCutSet");
-    windowSizeTiltedLayerRings_.reserve(pSetsTiltedLayer.size());
+    geometry.windowSizeTiltedLayerRings.reserve(pSetsTiltedLayer.size());
     for (const auto& pSet : pSetsTiltedLayer)
-      windowSizeTiltedLayerRings_.emplace_back(pSet.getParameter<vector<double>>("TiltedCut"));
-    windowSizeEndcapDisksRings_.reserve(pSetsEncapDisks.size());
+      geometry.windowSizeTiltedLayerRings.emplace_back(pSet.getParameter<vector<double>>("TiltedCut"));
+    geometry.windowSizeEndcapDisksRings.reserve(pSetsEncapDisks.size());
     for (const auto& pSet : pSetsEncapDisks)
-      windowSizeEndcapDisksRings_.emplace_back(pSet.getParameter<vector<double>>("EndcapCut"));
-    maxWindowSize_ = -1;
-    for (const auto& windowss : {windowSizeTiltedLayerRings_, windowSizeEndcapDisksRings_, {windowSizeBarrelLayers_}})
+      geometry.windowSizeEndcapDisksRings.emplace_back(pSet.getParameter<vector<double>>("EndcapCut"));
+    geometry.maxWindowSize = -1;
+    for (const auto& windowss :
+         {geometry.windowSizeTiltedLayerRings, geometry.windowSizeEndcapDisksRings, {geometry.windowSizeBarrelLayers}})
       for (const auto& windows : windowss)
         for (const auto& window : windows)
-          maxWindowSize_ = max(maxWindowSize_, (int)(window / baseWindowSize_));
+          geometry.maxWindowSize = max(geometry.maxWindowSize, (int)(window / baseWindowSize_));
   }
 
   // create bend encodings
   void Setup::encodeBend(vector<vector<double>>& encodings, bool ps) const {
-    for (int window = 0; window < maxWindowSize_ + 1; window++) {
+    for (int window = 0; window < geometry_->maxWindowSize + 1; window++) {
       set<double> encoding;
       for (int bend = 0; bend < window + 1; bend++)
         encoding.insert(stubAlgorithm_->degradeBend(ps, window, bend));
@@ -421,7 +653,7 @@ namespace trackerDTC {
   }
 
   // create encodingsLayerId
-  void Setup::encodeLayerId() {
+  void Setup::encodeLayerId(SetupGeometry& geometry) const {
     vector<vector<DTCELinkId>> dtcELinkIds(numDTCs_);
     for (vector<DTCELinkId>& dtcELinkId : dtcELinkIds)
       dtcELinkId.reserve(numModulesPerDTC_);
@@ -446,15 +678,15 @@ namespace trackerDTC {
         exception.addContext("tt::Setup::Setup");
         throw exception;
       }
-      encodingsLayerId_.emplace_back(encodingLayerId.begin(), encodingLayerId.end());
+      geometry.encodingsLayerId.emplace_back(encodingLayerId.begin(), encodingLayerId.end());
     }
   }
 
   // create sensor modules
-  void Setup::produceSensorModules() {
-    sensorModules_.reserve(numModules_);
-    dtcModules_ = vector<vector<SensorModule*>>(numDTCs_);
-    for (vector<SensorModule*>& dtcModules : dtcModules_)
+  void Setup::produceSensorModules(SetupGeometry& geometry) const {
+    geometry.sensorModules.reserve(numModules_);
+    geometry.dtcModules = vector<vector<SensorModule*>>(numDTCs_);
+    for (vector<SensorModule*>& dtcModules : geometry.dtcModules)
       dtcModules.reserve(numModulesPerDTC_);
     enum SubDetId { pixelBarrel = 1, pixelDisks = 2 };
     // loop over all tracker modules
@@ -472,16 +704,16 @@ namespace trackerDTC {
       // track trigger dtc id [0-215]
       const int dtcId = Setup::dtcId(tklId);
       // collection of so far connected modules to this dtc
-      vector<SensorModule*>& dtcModules = dtcModules_[dtcId];
+      vector<SensorModule*>& dtcModules = geometry.dtcModules[dtcId];
       // construct sendor module
-      sensorModules_.emplace_back(*this, detId, dtcId, dtcModules.size());
-      SensorModule* sensorModule = &sensorModules_.back();
+      geometry.sensorModules.emplace_back(*this, detId, dtcId, dtcModules.size());
+      SensorModule* sensorModule = &geometry.sensorModules.back();
       // store connection between detId and sensor module
-      detIdToSensorModule_.emplace(detId, sensorModule);
+      geometry.detIdToSensorModule.emplace(detId, sensorModule);
       // store connection between dtcId and sensor module
       dtcModules.push_back(sensorModule);
     }
-    for (vector<SensorModule*>& dtcModules : dtcModules_) {
+    for (vector<SensorModule*>& dtcModules : geometry.dtcModules) {
       dtcModules.shrink_to_fit();
       // check configuration
       if ((int)dtcModules.size() > numModulesPerDTC_) {
@@ -514,6 +746,8 @@ namespace trackerDTC {
   //
   int Setup::layerId(const TTStubRef& ttStubRef) const {
     const DetId& detId = ttStubRef->getDetId();
+    if (!trackerTopology_)
+      return sensorModule(detId + offsetDetIdDSV_)->layerId();
     return detId.subdetId() == StripSubdetector::TOB ? trackerTopology_->layer(detId)
                                                      : trackerTopology_->tidWheel(detId) + offsetLayerDisks_;
   }
@@ -527,6 +761,8 @@ namespace trackerDTC {
   //
   int Setup::psModule(const TTStubRef& ttStubRef) const {
     const DetId& detId = ttStubRef->getDetId();
+    if (!trackerGeometry_)
+      return sensorModule(detId + offsetDetIdDSV_)->psModule();
     return trackerGeometry_->getDetectorType(detId) == TrackerGeometry::ModuleType::Ph2PSP;
   }
 
@@ -655,7 +891,7 @@ namespace trackerDTC {
     // DR
     drBaseQoverPt_ = htBaseQoverPt_ * pow(2, htWidthQoverPt_ - drWidthQoverPt_);
     drBasePhi0_ = basePhi_ * pow(2, widthPhiDTC_ - drWidthPhi0_);
-    drBaseCot_ = floor(log2(2. * maxCot_ * pow(2, -drWidthCot_)));
+    drBaseCot_ = pow(2, floor(log2(2. * maxCot_ * pow(2, -drWidthCot_))));
     drBaseZ0_ = baseZ_ * pow(2, ceil(log2(2. * beamWindowZ_ / baseZ_)) - drWidthZ0_);
     // KF
     kfBasex0_ = drBaseQoverPt_;
@@ -700,67 +936,127 @@ namespace trackerDTC {
     GlobalPoint p;
     if (frame.first.isNull())
       return p;
-    TTBV bv(frame.second);
-    if (hybrid) {
-      const DetId& detId = frame.first->getDetId();
-      const int dtcId = Setup::dtcId(tfpRegion, tfpChannel);
-      const bool barrel = detId.subdetId() == StripSubdetector::TOB;
-      const bool psModule = Setup::psModule(dtcId);
-      const int layerId =
-          (barrel ? trackerTopology_->layer(detId) : trackerTopology_->tidWheel(detId)) - offsetLayerId_;
-      const bool side = Setup::side(dtcId);
+    double r, phi, z;
+    stubPos(stubPosDecoder(hybrid, tfpRegion, tfpChannel), frame, r, phi, z);
+    p = GlobalPoint(GlobalPoint::Cylindrical(r, phi, z));
+    return p;
+  }
+
+  // bit accurate positions of all frames of a tfp channel, appends r [cm], phi [rad], z [cm] per frame, 0 for gaps
+  void Setup::stubPos(bool hybrid,
+                      const TTDTC::Stream& stream,
+                      int tfpRegion,
+                      int tfpChannel,
+                      vector<double>& r,
+                      vector<double>& phi,
+                      vector<double>& z) const {
+    const StubPosDecoder decoder = stubPosDecoder(hybrid, tfpRegion, tfpChannel);
+    const int offset = r.size();
+    r.resize(offset + stream.size(), 0.);
+    phi.resize(offset + stream.size(), 0.);
+    z.resize(offset + stream.size(), 0.);
+    for (int frame = 0; frame < (int)stream.size(); frame++)
+      if (stream[frame].first.isNonnull())
+        stubPos(decoder, stream[frame], r[offset + frame], phi[offset + frame], z[offset + frame]);
+  }
+
+  // bit accurate positions of all frames of a tfp region, channel by channel
+  void Setup::stubPos(
+      bool hybrid, const TTDTC& ttDTC, int tfpRegion, vector<double>& r, vector<double>& phi, vector<double>& z) const {
+    int size(0);
+    for (int channel = 0; channel < numDTCsPerTFP_; channel++)
+      size += ttDTC.stream(tfpRegion, channel).size();
+    r.reserve(r.size() + size);
+    phi.reserve(phi.size() + size);
+    z.reserve(z.size() + size);
+    for (int channel = 0; channel < numDTCsPerTFP_; channel++)
+      stubPos(hybrid, ttDTC.stream(tfpRegion, channel), tfpRegion, channel, r, phi, z);
+  }
+
+  // collects all constants needed to decode stub positions of given tfp channel, range checks happen here
+  Setup::StubPosDecoder Setup::stubPosDecoder(bool hybrid, int tfpRegion, int tfpChannel) const {
+    const int dtcId = Setup::dtcId(tfpRegion, tfpChannel);
+    StubPosDecoder decoder;
+    decoder.hybrid_ = hybrid;
+    decoder.side_ = Setup::side(dtcId);
+    decoder.psModule_ = Setup::psModule(dtcId);
+    decoder.offsetPhi_ = tfpRegion * baseRegion_;
+    if (!hybrid) {
+      decoder.lsb_.fill(2 * htWidthQoverPt_ + 2 * widthSectorEta_ + numSectorsPhi_ + widthLayerId_);
+      decoder.widthPhi_.fill(widthPhiDTC_);
+      decoder.widthZ_.fill(widthZ_);
+      decoder.widthR_.fill(widthR_);
+      decoder.basePhi_.fill(basePhi_);
+      decoder.baseZ_.fill(baseZ_);
+      decoder.baseR_.fill(baseR_);
+      return decoder;
+    }
+    for (bool barrel : {false, true}) {
       SensorModule::Type type;
-      if (barrel && psModule)
-        type = SensorModule::BarrelPS;
-      if (barrel && !psModule)
-        type = SensorModule::Barrel2S;
-      if (!barrel && psModule)
-        type = SensorModule::DiskPS;
-      if (!barrel && !psModule)
-        type = SensorModule::Disk2S;
-      const int widthBend = hybridWidthsBend_.at(type);
-      const int widthAlpha = hybridWidthsAlpha_.at(type);
-      const int widthPhi = hybridWidthsPhi_.at(type);
-      const int widthZ = hybridWidthsZ_.at(type);
-      const int widthR = hybridWidthsR_.at(type);
-      const double basePhi = hybridBasesPhi_.at(type);
-      const double baseZ = hybridBasesZ_.at(type);
-      const double baseR = hybridBasesR_.at(type);
-      // parse bit vector
-      bv >>= 1 + hybridWidthLayerId_ + widthBend + widthAlpha;
-      double phi = (bv.val(widthPhi, 0, true) + .5) * basePhi;
-      bv >>= widthPhi;
-      double z = (bv.val(widthZ, 0, true) + .5) * baseZ;
-      bv >>= widthZ;
-      double r = (bv.val(widthR, 0, barrel) + .5) * baseR;
-      if (barrel) {
-        r += hybridLayerRs_.at(layerId);
-      } else {
-        z += hybridDiskZs_.at(layerId) * (side ? 1. : -1.);
-      }
-      phi = deltaPhi(phi + tfpRegion * baseRegion_);
-      if (type == SensorModule::Disk2S) {
-        r = bv.val(widthR);
-        r = disk2SRs_.at(layerId).at((int)r);
-      }
-      p = GlobalPoint(GlobalPoint::Cylindrical(r, phi, z));
-    } else {
-      bv >>= 2 * htWidthQoverPt_ + 2 * widthSectorEta_ + numSectorsPhi_ + widthLayerId_;
-      double z = (bv.val(widthZ_, 0, true) + .5) * baseZ_;
-      bv >>= widthZ_;
-      double phi = (bv.val(widthPhiDTC_, 0, true) + .5) * basePhi_;
-      bv >>= widthPhiDTC_;
-      double r = (bv.val(widthR_, 0, true) + .5) * baseR_;
-      bv >>= widthR_;
-      r = r + chosenRofPhi_;
-      phi = deltaPhi(phi + tfpRegion * baseRegion_);
-      p = GlobalPoint(GlobalPoint::Cylindrical(r, phi, z));
+      if (barrel)
+        type = decoder.psModule_ ? SensorModule::BarrelPS : SensorModule::Barrel2S;
+      else
+        type = decoder.psModule_ ? SensorModule::DiskPS : SensorModule::Disk2S;
+      decoder.lsb_[barrel] = 1 + hybridWidthLayerId_ + hybridWidthsBend_.at(type) + hybridWidthsAlpha_.at(type);
+      decoder.widthPhi_[barrel] = hybridWidthsPhi_.at(type);
+      decoder.widthZ_[barrel] = hybridWidthsZ_.at(type);
+      decoder.widthR_[barrel] = hybridWidthsR_.at(type);
+      decoder.basePhi_[barrel] = hybridBasesPhi_.at(type);
+      decoder.baseZ_[barrel] = hybridBasesZ_.at(type);
+      decoder.baseR_[barrel] = hybridBasesR_.at(type);
     }
-    return p;
+    return decoder;
+  }
+
+  // decodes bit accurate position of a valid frame
+  void Setup::stubPos(
+      const StubPosDecoder& decoder, const TTDTC::Frame& frame, double& r, double& phi, double& z) const {
+    // extracts width bits starting at lsb, optionally interpreted as two's complement
+    auto extract = [](unsigned long long word, int lsb, int width, bool twos) {
+      const int value = (word >> lsb) & ((1ULL << width) - 1);
+      return twos && (value >> (width - 1)) ? value - (1 << width) : value;
+    };
+    const unsigned long long word = frame.second.to_ullong();
+    if (!decoder.hybrid_) {
+      // TMTT: from lsb z, phi, r
+      const int lsbZ = decoder.lsb_[0];
+      z = (extract(word, lsbZ, widthZ_, true) + .5) * baseZ_;
+      phi = (extract(word, lsbZ + widthZ_, widthPhiDTC_, true) + .5) * basePhi_;
+      r = (extract(word, lsbZ + widthZ_ + widthPhiDTC_, widthR_, true) + .5) * baseR_ + chosenRofPhi_;
+      phi = deltaPhi(phi + decoder.offsetPhi_);
+      return;
+    }
+    // hybrid: from lsb phi, z, r
+    const DetId& detId = frame.first->getDetId();
+    const bool barrel = detId.subdetId() == StripSubdetector::TOB;
+    int layerId;
+    if (trackerTopology_)
+      layerId = (barrel ? trackerTopology_->layer(detId) : trackerTopology_->tidWheel(detId)) - offsetLayerId_;
+    else
+      layerId = sensorModule(detId + offsetDetIdDSV_)->layerId() - offsetLayerId_ - (barrel ? 0 : offsetLayerDisks_);
+    const int lsbPhi = decoder.lsb_[barrel];
+    const int lsbZ = lsbPhi + decoder.widthPhi_[barrel];
+    const int lsbR = lsbZ + decoder.widthZ_[barrel];
+    phi = (extract(word, lsbPhi, decoder.widthPhi_[barrel], true) + .5) * decoder.basePhi_[barrel];
+    z = (extract(word, lsbZ, decoder.widthZ_[barrel], true) + .5) * decoder.baseZ_[barrel];
+    r = (extract(word, lsbR, decoder.widthR_[barrel], barrel) + .5) * decoder.baseR_[barrel];
+    if (barrel)
+      r += hybridLayerRs_[layerId];
+    else
+      z += hybridDiskZs_[layerId] * (decoder.side_ ? 1. : -1.);
+    phi = deltaPhi(phi + decoder.offsetPhi_);
+    if (!barrel && !decoder.psModule_)
+      r = disk2SRs_[layerId][extract(word, lsbR, decoder.widthR_[barrel], false)];
   }
 
   // returns global TTStub position
   GlobalPoint Setup::stubPos(const TTStubRef& ttStubRef) const {
+    if (!trackerGeometry_) {
+      cms::Exception exception("NullPtr");
+      exception << "Global TTStub position requires TrackerGeometry, not available if constructed from module table.";
+      exception.addContext("trackerDTC::Setup::stubPos");
+      throw exception;
+    }
     const DetId detId = ttStubRef->getDetId() + offsetDetIdDSV_;
     const GeomDetUnit* det = trackerGeometry_->idToDetUnit(detId);
     const PixelTopology* topol =
@@ -1,4 +1,5 @@
 #include "L1Trigger/TrackerDTC/interface/SetupRcd.h"
 #include "FWCore/Framework/interface/eventsetuprecord_registration_macro.h"
 
-EVENTSETUP_RECORD_REG(trackerDTC::SetupRcd);
\ No newline at end of file
+EVENTSETUP_RECORD_REG(trackerDTC::SetupGeometryRcd);
+EVENTSETUP_RECORD_REG(trackerDTC::SetupRcd);
@@ -348,14 +348,16 @@ namespace trackerDTC {
 
   // fill stub related histograms
   void Analyzer::analyzeStream(const TTDTC::Stream& stream, int region, int channel, int& sum, TH2F* th2f) {
-    for (const TTDTC::Frame& frame : stream) {
+    // bit accurate stub positions of whole stream
+    vector<double> rs, phis, zs;
+    setup_.stubPos(hybrid_, stream, region, channel, rs, phis, zs);
+    for (int i = 0; i < (int)stream.size(); i++) {
+      const TTDTC::Frame& frame = stream[i];
       if (frame.first.isNull())
         continue;
       sum++;
-      const GlobalPoint& pos = setup_.stubPos(hybrid_, frame, region, channel);
       const GlobalPoint& ttPos = setup_.stubPos(frame.first);
-      const vector<double> resolutions = {
-          ttPos.perp() - pos.perp(), deltaPhi(ttPos.phi() - pos.phi()), ttPos.z() - pos.z()};
+      const vector<double> resolutions = {ttPos.perp() - rs[i], deltaPhi(ttPos.phi() - phis[i]), ttPos.z() - zs[i]};
       for (Resolution r : AllResolution) {
         hisResolution_[r]->Fill(resolutions[r]);
         profResolution_[r]->Fill(ttPos.z(), ttPos.perp(), abs(resolutions[r]));
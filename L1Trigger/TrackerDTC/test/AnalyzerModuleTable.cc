@@ -0,0 +1,178 @@
+#include "FWCore/Framework/interface/one/EDAnalyzer.h"
+#include "FWCore/Framework/interface/Run.h"
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/MakerMacros.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "L1Trigger/TrackerDTC/interface/Setup.h"
+#include "L1Trigger/TrackerDTC/interface/SensorModule.h"
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cstdio>
+
+using namespace std;
+using namespace edm;
+
+namespace trackerDTC {
+
+  /*! \class  trackerDTC::AnalyzerModuleTable
+   *  \brief  Class to check the standalone Setup construction. Writes the module table of the EventSetup built Setup,
+   *          rebuilds a Setup from it and requires all SensorModules to be reproduced bit by bit. A truncated and a
+   *          corrupted copy of the table have to be rejected.
+   *  \author Thomas Schuh
+   *  \date   2020, Nov
+   */
+  class AnalyzerModuleTable : public one::EDAnalyzer<one::WatchRuns> {
+  public:
+    AnalyzerModuleTable(const ParameterSet& iConfig);
+    void beginJob() override {}
+    void beginRun(const Run& iEvent, const EventSetup& iSetup) override;
+    void analyze(const Event& iEvent, const EventSetup& iSetup) override {}
+    void endRun(const Run& iEvent, const EventSetup& iSetup) override {}
+    void endJob() override;
+
+  private:
+    // compares all SensorModule fields, doubles bit by bit
+    void compare(const SensorModule& lhs, const SensorModule& rhs) const;
+    // throws unless standalone construction from fileName fails with FileReadError
+    void expectReadError(const string& fileName, const string& what) const;
+    // throws LogicError
+    void fail(const string& what) const;
+
+    // configuration of standalone Setups
+    ParameterSet iConfig_;
+    // module table written and reread by this test
+    string moduleTableFile_;
+    // Setup token
+    ESGetToken<Setup, SetupRcd> esGetToken_;
+    // number of compared sensor modules
+    int numSensorModules_;
+
+    // printout
+    stringstream log_;
+  };
+
+  AnalyzerModuleTable::AnalyzerModuleTable(const ParameterSet& iConfig)
+      : iConfig_(iConfig),
+        moduleTableFile_(iConfig.getParameter<string>("ModuleTableFile")),
+        numSensorModules_(0) {
+    // book ES product
+    esGetToken_ = esConsumes<Setup, SetupRcd, Transition::BeginRun>();
+  }
+
+  void AnalyzerModuleTable::beginRun(const Run& iEvent, const EventSetup& iSetup) {
+    const Setup& setup = iSetup.getData(esGetToken_);
+    setup.writeModuleTable(moduleTableFile_);
+    const Setup standalone(iConfig_, moduleTableFile_);
+    if (standalone.configurationSupported() != setup.configurationSupported())
+      fail("configurationSupported");
+    if (!setup.configurationSupported())
+      return;
+    const SetupGeometry& geometry = *setup.geometry();
+    const SetupGeometry& reread = *standalone.geometry();
+    if (reread.numTiltedLayerRings != geometry.numTiltedLayerRings ||
+        reread.windowSizeBarrelLayers != geometry.windowSizeBarrelLayers ||
+        reread.windowSizeTiltedLayerRings != geometry.windowSizeTiltedLayerRings ||
+        reread.windowSizeEndcapDisksRings != geometry.windowSizeEndcapDisksRings ||
+        reread.maxWindowSize != geometry.maxWindowSize)
+      fail("TTStubAlgorithm windows");
+    if (reread.encodingsBendPS != geometry.encodingsBendPS || reread.encodingsBend2S != geometry.encodingsBend2S ||
+        reread.encodingsLayerId != geometry.encodingsLayerId)
+      fail("encodings");
+    if (reread.sensorModules.size() != geometry.sensorModules.size())
+      fail("number of sensor modules");
+    for (int i = 0; i < (int)geometry.sensorModules.size(); i++)
+      compare(reread.sensorModules[i], geometry.sensorModules[i]);
+    // cabling and detId look up have to point to the same modules
+    for (int dtcId = 0; dtcId < setup.numDTCs(); dtcId++) {
+      const vector<SensorModule*>& dtcModules = setup.dtcModules(dtcId);
+      const vector<SensorModule*>& dtcModulesReread = standalone.dtcModules(dtcId);
+      if (dtcModulesReread.size() != dtcModules.size())
+        fail("dtcModules");
+      for (int i = 0; i < (int)dtcModules.size(); i++)
+        if (dtcModulesReread[i]->detId() != dtcModules[i]->detId() ||
+            standalone.sensorModule(dtcModules[i]->detId()) != dtcModulesReread[i])
+          fail("dtcModules");
+    }
+    numSensorModules_ += geometry.sensorModules.size();
+    // read in table line by line to manipulate it
+    vector<string> lines;
+    ifstream stream(moduleTableFile_);
+    for (string line; getline(stream, line);)
+      lines.push_back(line);
+    stream.close();
+    // truncated table, cut in the middle of the sensor module lines
+    const string truncated = moduleTableFile_ + ".truncated";
+    ofstream streamTruncated(truncated);
+    for (int i = 0; i < (int)lines.size() - (int)geometry.sensorModules.size() / 2; i++)
+      streamTruncated << lines[i] << endl;
+    streamTruncated.close();
+    expectReadError(truncated, "truncated");
+    // corrupted table, last sensor module line starts with a non number
+    const string corrupted = moduleTableFile_ + ".corrupted";
+    lines.back().replace(0, lines.back().find(' '), "corrupted");
+    ofstream streamCorrupted(corrupted);
+    for (const string& line : lines)
+      streamCorrupted << line << endl;
+    streamCorrupted.close();
+    expectReadError(corrupted, "corrupted");
+    remove(truncated.c_str());
+    remove(corrupted.c_str());
+    remove(moduleTableFile_.c_str());
+  }
+
+  void AnalyzerModuleTable::endJob() {
+    log_ << "                 MODULE TABLE  SUMMARY                       " << endl;
+    log_ << "reproduced sensor modules = " << numSensorModules_ << endl;
+    log_ << "=============================================================";
+    LogPrint("L1Trigger/TrackerDTC") << log_.str();
+  }
+
+  // compares all SensorModule fields, doubles bit by bit
+  void AnalyzerModuleTable::compare(const SensorModule& lhs, const SensorModule& rhs) const {
+    auto identical = [](double a, double b) { return memcmp(&a, &b, sizeof(double)) == 0; };
+    if (lhs.detId() != rhs.detId() || lhs.type() != rhs.type() || lhs.dtcId() != rhs.dtcId() ||
+        lhs.modId() != rhs.modId() || lhs.side() != rhs.side() || lhs.barrel() != rhs.barrel() ||
+        lhs.psModule() != rhs.psModule() || lhs.flipped() != rhs.flipped() || lhs.signRow() != rhs.signRow() ||
+        lhs.signCol() != rhs.signCol() || lhs.signBend() != rhs.signBend() || lhs.numColumns() != rhs.numColumns() ||
+        lhs.numRows() != rhs.numRows() || lhs.layerId() != rhs.layerId() || lhs.encodedR() != rhs.encodedR() ||
+        lhs.encodedLayerId() != rhs.encodedLayerId() || lhs.windowSize() != rhs.windowSize())
+      fail("integer field of sensor module " + to_string(rhs.detId().rawId()));
+    if (!identical(lhs.r(), rhs.r()) || !identical(lhs.phi(), rhs.phi()) || !identical(lhs.z(), rhs.z()) ||
+        !identical(lhs.sep(), rhs.sep()) || !identical(lhs.pitchRow(), rhs.pitchRow()) ||
+        !identical(lhs.pitchCol(), rhs.pitchCol()) || !identical(lhs.tilt(), rhs.tilt()) ||
+        !identical(lhs.sin(), rhs.sin()) || !identical(lhs.cos(), rhs.cos()) ||
+        !identical(lhs.offsetR(), rhs.offsetR()) || !identical(lhs.offsetZ(), rhs.offsetZ()))
+      fail("floating point field of sensor module " + to_string(rhs.detId().rawId()));
+  }
+
+  // throws unless standalone construction from fileName fails with FileReadError
+  void AnalyzerModuleTable::expectReadError(const string& fileName, const string& what) const {
+    try {
+      const Setup setup(iConfig_, fileName);
+    } catch (const cms::Exception& exception) {
+      if (exception.category() == "FileReadError")
+        return;
+      throw;
+    }
+    fail(what + " module table has been accepted");
+  }
+
+  // throws LogicError
+  void AnalyzerModuleTable::fail(const string& what) const {
+    cms::Exception exception("LogicError");
+    exception << "Module table round trip failed: " << what << ".";
+    exception.addContext("trackerDTC::AnalyzerModuleTable::fail");
+    throw exception;
+  }
+
+}  // namespace trackerDTC
+
+DEFINE_FWK_MODULE(trackerDTC::AnalyzerModuleTable);
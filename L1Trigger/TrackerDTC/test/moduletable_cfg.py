@@ -0,0 +1,30 @@
+################################################################################################
+# Checks writing a module table and rebuilding the Setup from it
+# To run execute do
+# cmsRun L1Trigger/TrackerDTC/test/moduletable_cfg.py
+#################################################################################################
+
+import FWCore.ParameterSet.Config as cms
+
+process = cms.Process( "Demo" )
+process.load( 'Configuration.Geometry.GeometryExtended2026D49Reco_cff' )
+process.load( 'Configuration.StandardSequences.MagneticField_cff' )
+process.load( 'Configuration.StandardSequences.FrontierConditions_GlobalTag_cff' )
+process.load( 'Configuration.StandardSequences.L1TrackTrigger_cff' )
+process.load( "FWCore.MessageLogger.MessageLogger_cfi" )
+
+from Configuration.AlCa.GlobalTag import GlobalTag
+process.GlobalTag = GlobalTag( process.GlobalTag, 'auto:phase2_realistic', '' )
+
+# load code that produces the Setup
+process.load( 'L1Trigger.TrackerDTC.ProducerES_cff' )
+# load code that checks the module table
+process.load( 'L1Trigger.TrackerDTC.Analyzer_cff' )
+
+# build schedule
+process.analyze = cms.Path( process.TrackerDTCAnalyzerModuleTable )
+process.schedule = cms.Schedule( process.analyze )
+
+process.options = cms.untracked.PSet( wantSummary = cms.untracked.bool(False) )
+process.maxEvents = cms.untracked.PSet( input = cms.untracked.int32(1) )
+process.source = cms.Source( "EmptySource" )
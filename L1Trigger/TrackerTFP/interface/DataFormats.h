@@ -6,16 +6,18 @@
 #include "L1Trigger/TrackerDTC/interface/Setup.h"
 
 #include <vector>
+#include <array>
 #include <cmath>
 #include <initializer_list>
 #include <tuple>
 #include <iostream>
+#include <string>
 
 namespace trackerTFP {
 
-  enum class Process { begin, fe = begin, dtc, pp, gp, lf, end, x };
+  enum class Process { begin, fe = begin, dtc, pp, gp, lf, lr, mht, sf, kf, dr, end, x };
   enum class Variable { begin, r = begin, phi, z, layer, sectorsPhi, sectorEta, sectorPhi, phiT, qOverPt, zT, cot, end, x };
-  constexpr std::initializer_list<Process> Processes = {Process::fe, Process::dtc, Process::pp, Process::gp, Process::lf};
+  constexpr std::initializer_list<Process> Processes = {Process::fe, Process::dtc, Process::pp, Process::gp, Process::lf, Process::lr, Process::mht, Process::sf, Process::kf, Process::dr};
   constexpr std::initializer_list<Variable> Variables = {Variable::r, Variable::phi, Variable::z, Variable::layer, Variable::sectorsPhi, Variable::sectorEta, Variable::sectorPhi, Variable::phiT, Variable::qOverPt, Variable::zT, Variable::cot};
   inline constexpr int operator+(Process p) { return static_cast<int>(p); }
   inline constexpr int operator+(Variable v) { return static_cast<int>(v); }
@@ -73,30 +75,98 @@ namespace trackerTFP {
   template<> Format<Variable::phiT, Process::lf>::Format(const trackerDTC::Setup* setup);
   template<> Format<Variable::qOverPt, Process::lf>::Format(const trackerDTC::Setup* setup);
 
+  template<> Format<Variable::phiT, Process::lr>::Format(const trackerDTC::Setup* setup);
+  template<> Format<Variable::qOverPt, Process::lr>::Format(const trackerDTC::Setup* setup);
+  template<> Format<Variable::zT, Process::lr>::Format(const trackerDTC::Setup* setup);
+  template<> Format<Variable::cot, Process::lr>::Format(const trackerDTC::Setup* setup);
+
+  template<> Format<Variable::phiT, Process::mht>::Format(const trackerDTC::Setup* setup);
+  template<> Format<Variable::qOverPt, Process::mht>::Format(const trackerDTC::Setup* setup);
+
+  template<> Format<Variable::zT, Process::sf>::Format(const trackerDTC::Setup* setup);
+  template<> Format<Variable::cot, Process::sf>::Format(const trackerDTC::Setup* setup);
+
+  template<> Format<Variable::phiT, Process::kf>::Format(const trackerDTC::Setup* setup);
+  template<> Format<Variable::qOverPt, Process::kf>::Format(const trackerDTC::Setup* setup);
+  template<> Format<Variable::zT, Process::kf>::Format(const trackerDTC::Setup* setup);
+  template<> Format<Variable::cot, Process::kf>::Format(const trackerDTC::Setup* setup);
+
+  // position and format of a variable inside a stub frame, used to convert frames without TTBV shifting
+  class Field {
+  public:
+    Field(const DataFormat* format, int offset);
+    ~Field() {}
+    // field content with sign reinterpretation
+    int integer(unsigned long long word) const;
+    void extract(unsigned long long word, int& out) const { out = integer(word); }
+    void extract(unsigned long long word, double& out) const { out = (integer(word) + .5) * base_; }
+    void extract(unsigned long long word, TTBV& out) const { out = TTBV(TTBV(bits(word), width_), width_, 0, twos_); }
+    void attach(const int i, unsigned long long& word) const { word |= pattern(i) << offset_; }
+    void attach(const double d, unsigned long long& word) const { attach((int)std::floor(d / base_), word); }
+    void attach(const TTBV& bv, unsigned long long& word) const { word |= (bv.bs().to_ullong() & mask_) << offset_; }
+    int offset() const { return offset_; }
+    int width() const { return width_; }
+    bool twos() const { return twos_; }
+    double base() const { return base_; }
+  private:
+    // unsigned field content
+    unsigned long long bits(unsigned long long word) const { return (word >> offset_) & mask_; }
+    // bit pattern as produced by TTBV(int, width, twos), out of range values are not truncated
+    unsigned long long pattern(int i) const { return twos_ && i < 0 ? i + (1ULL << width_) : i; }
+    int offset_;
+    int width_;
+    bool twos_;
+    double base_;
+    unsigned long long mask_;
+  };
+
   class DataFormats {
   private:
     static constexpr std::array<std::array<Process, +Process::end>, +Variable::end> config_ = {{
-    //  Process::fe  Process::dtc  Process::pp   Process::gp  Process::lf
-      {{Process::x,  Process::lf,  Process::lf,  Process::lf, Process::lf}}, // Variable::r
-      {{Process::x,  Process::dtc, Process::dtc, Process::gp, Process::lf}}, // Variable::phi
-      {{Process::x,  Process::dtc, Process::dtc, Process::gp, Process::gp}}, // Variable::z
-      {{Process::x,  Process::lf,  Process::lf,  Process::lf, Process::lf}}, // Variable::layer
-      {{Process::x,  Process::dtc, Process::dtc, Process::x,  Process::x }}, // Variable::sectorsPhi
-      {{Process::x,  Process::gp,  Process::gp,  Process::gp, Process::gp}}, // Variable::sectorEta
-      {{Process::x,  Process::x,   Process::x,   Process::gp, Process::gp}}, // Variable::sectorPhi
-      {{Process::x,  Process::lf,  Process::lf,  Process::lf, Process::lf}}, // Variable::phiT
-      {{Process::x,  Process::lf,  Process::lf,  Process::lf, Process::lf}}, // Variable::qOverPt
-      {{Process::x,  Process::x,   Process::x,   Process::x,  Process::x }}, // Variable::zT
-      {{Process::x,  Process::x,   Process::x,   Process::x,  Process::x }}, // Variable::cot
+    //  Process::fe  Process::dtc  Process::pp   Process::gp  Process::lf  Process::lr  Process::mht  Process::sf   Process::kf   Process::dr
+      {{Process::x,  Process::lf,  Process::lf,  Process::lf, Process::lf, Process::lf, Process::lf,  Process::lf,  Process::lf,  Process::lf }}, // Variable::r
+      {{Process::x,  Process::dtc, Process::dtc, Process::gp, Process::lf, Process::lf, Process::lf,  Process::lf,  Process::lf,  Process::lf }}, // Variable::phi
+      {{Process::x,  Process::dtc, Process::dtc, Process::gp, Process::gp, Process::gp, Process::gp,  Process::gp,  Process::gp,  Process::gp }}, // Variable::z
+      {{Process::x,  Process::lf,  Process::lf,  Process::lf, Process::lf, Process::lf, Process::lf,  Process::lf,  Process::lf,  Process::lf }}, // Variable::layer
+      {{Process::x,  Process::dtc, Process::dtc, Process::x,  Process::x,  Process::x,  Process::x,   Process::x,   Process::x,   Process::x  }}, // Variable::sectorsPhi
+      {{Process::x,  Process::gp,  Process::gp,  Process::gp, Process::gp, Process::gp, Process::gp,  Process::gp,  Process::gp,  Process::gp }}, // Variable::sectorEta
+      {{Process::x,  Process::x,   Process::x,   Process::gp, Process::gp, Process::gp, Process::gp,  Process::gp,  Process::gp,  Process::gp }}, // Variable::sectorPhi
+      {{Process::x,  Process::lf,  Process::lf,  Process::lf, Process::lf, Process::lr, Process::mht, Process::mht, Process::kf,  Process::kf }}, // Variable::phiT
+      {{Process::x,  Process::lf,  Process::lf,  Process::lf, Process::lf, Process::lr, Process::mht, Process::mht, Process::kf,  Process::kf }}, // Variable::qOverPt
+      {{Process::x,  Process::x,   Process::x,   Process::x,  Process::x,  Process::lr, Process::x,   Process::sf,  Process::kf,  Process::kf }}, // Variable::zT
+      {{Process::x,  Process::x,   Process::x,   Process::x,  Process::x,  Process::lr, Process::x,   Process::sf,  Process::kf,  Process::kf }}, // Variable::cot
     }};
     static constexpr std::array<std::initializer_list<Variable>, +Process::end> stubs_ = {{
       {},                                                                                                                                                                  // Process::fe
       {Variable::r, Variable::phi, Variable::z, Variable::layer, Variable::sectorsPhi, Variable::sectorEta, Variable::sectorEta, Variable::qOverPt, Variable::qOverPt},    // Process::dtc
       {Variable::r, Variable::phi, Variable::z, Variable::layer, Variable::sectorsPhi, Variable::sectorEta, Variable::sectorEta, Variable::qOverPt, Variable::qOverPt},    // Process::pp
       {Variable::r, Variable::phi, Variable::z, Variable::layer, Variable::qOverPt, Variable::qOverPt},                                                                    // Process::gp
-      {Variable::r, Variable::phi, Variable::z, Variable::layer, Variable::sectorPhi, Variable::sectorEta, Variable::phiT}                                                 // Process::lf
+      {Variable::r, Variable::phi, Variable::z, Variable::layer, Variable::sectorPhi, Variable::sectorEta, Variable::phiT},                                                // Process::lf
+      {Variable::r, Variable::phi, Variable::z, Variable::layer},                                                                                                         // Process::lr
+      {Variable::r, Variable::phi, Variable::z, Variable::layer},                                                                                                         // Process::mht
+      {Variable::r, Variable::phi, Variable::z, Variable::layer},                                                                                                         // Process::sf
+      {Variable::r, Variable::phi, Variable::z, Variable::layer},                                                                                                         // Process::kf
+      {Variable::r, Variable::phi, Variable::z, Variable::layer}                                                                                                          // Process::dr
+    }};
+    // track parameter per process, stored in the first track frame, the second frame holds hit layer pattern and
+    // position of stubs
+    static constexpr std::array<std::initializer_list<Variable>, +Process::end> tracks_ = {{
+      {},                                                                                                         // Process::fe
+      {},                                                                                                         // Process::dtc
+      {},                                                                                                         // Process::pp
+      {},                                                                                                         // Process::gp
+      {Variable::sectorPhi, Variable::sectorEta, Variable::qOverPt, Variable::phiT},                              // Process::lf
+      {Variable::sectorPhi, Variable::sectorEta, Variable::qOverPt, Variable::phiT, Variable::cot, Variable::zT}, // Process::lr
+      {Variable::sectorPhi, Variable::sectorEta, Variable::qOverPt, Variable::phiT},                              // Process::mht
+      {Variable::sectorPhi, Variable::sectorEta, Variable::qOverPt, Variable::phiT, Variable::cot, Variable::zT}, // Process::sf
+      {Variable::sectorPhi, Variable::sectorEta, Variable::qOverPt, Variable::phiT, Variable::cot, Variable::zT}, // Process::kf
+      {Variable::sectorPhi, Variable::sectorEta, Variable::qOverPt, Variable::phiT, Variable::cot, Variable::zT}  // Process::dr
     }};
   public:
+    // number of bits used by track frames to address stubs of a stream
+    static constexpr int widthStubs_ = 16;
+    // number of frames a track occupies in a track stream
+    static constexpr int numFramesTrack_ = 2;
     DataFormats();
     DataFormats(const trackerDTC::Setup* setup);
     ~DataFormats(){}
@@ -111,6 +181,31 @@ namespace trackerTFP {
     int numChannel(Process p) const { return numChannel_[+p]; }
     int numStreams(Process p) const { return numStreams_[+p]; }
     const DataFormat& format(Variable v, Process p) const { return *formats_[+v][+p]; }
+    // stub layout of given process, ordered like the stub variables
+    const std::vector<Field>& fields(Process p) const { return fields_[+p]; }
+    // track parameter of given process, ordered as stored in track frames
+    const std::initializer_list<Variable>& tracks(Process p) const { return tracks_[+p]; }
+    // returns n for ratio = 2^n, throws if ratio is not a power of two
+    static int exponent(double ratio, const std::string& name);
+    // integer domain sector phi residual, gp phi from pp phi
+    int phiGP(int phi, int sectorPhi) const {
+      return floorShift(phi * (1LL << gpShift_) - offsetsPhi_[sectorPhi], gpShift_);
+    }
+    // batch version, transforms n pp phis in place, each into its own phi sector
+    void phiGP(int* phi, const int* sectorPhi, int n) const;
+    // integer domain sector z residual, gp z from pp z and r
+    int zGP(int z, int r, int sectorEta) const { return z + offsetsZ_[sectorEta * widthOffsetsZ_ + r + offsetR_]; }
+    // batch version, transforms n pp zs in place, each into its own eta sector
+    void zGP(int* z, const int* r, const int* sectorEta, int n) const;
+    // integer domain track phi residual, lf phi from gp phi, r, qOverPt and phiT
+    int phiLF(int phi, int r, int qOverPt, int phiT) const;
+    // integer domain hough transform, returns true if stub belongs to a second (minor) phiT bin as well
+    bool phiT(int phi, int r, int qOverPt, int& major, int& minor) const;
+    // batch version for n stubs, minor equals major if a stub belongs to one phiT bin only
+    void phiT(const int* phi, const int* r, int n, int qOverPt, int* major, int* minor) const;
+    // integer domain mini hough transform, returns phiT bin inside lf cell for given fine qOverPt bin inside lf cell,
+    // lf phi is replaced by the residual to the centre of the fine cell
+    int phiTMHT(int& phi, int r, int binQoverPt) const;
   private:
     int numDataFormats_;
     template<Variable v = Variable::begin, Process p = Process::begin>
@@ -119,16 +214,48 @@ namespace trackerTFP {
     void fillDataFormats();
     template<Variable v, Process p, Process it = Process::begin>
     void fillFormats();
+    void fillFields();
+    // throws if track parameter or hit pattern plus stub position exceed a frame
+    void checkTracks() const;
+    // derives shifts and look up tables used for integer domain stub transformations
+    void fillIntegerDomain();
+    // floor(n / 2^shift) for both signs of n
+    static long long floorShift(long long n, int shift) { return n >= 0 ? n >> shift : ~(~n >> shift); }
     template<int it = 0, typename ...Ts>
-    void extract(TTBV& ttBV, std::tuple<Ts...>& data, Process p) const;
+    void extract(unsigned long long word, std::tuple<Ts...>& data, const std::vector<Field>& fields) const;
     template<int it = 0, typename... Ts>
-    void attach(const std::tuple<Ts...>& data, TTBV& ttBV, Process p) const;
+    void attach(const std::tuple<Ts...>& data, unsigned long long& word, const std::vector<Field>& fields) const;
     const trackerDTC::Setup* setup_;
     std::vector<DataFormat> dataFormats_;
     std::vector<std::vector<DataFormat*>> formats_;
+    // per process stub layout, ordered like stubs_
+    std::vector<std::vector<Field>> fields_;
     std::vector<int> numUnusedBits_;
     std::vector<int> numChannel_;
     std::vector<int> numStreams_;
+    // gp phi: common denominator 2^gpShift_ and sector phi offsets in units of it indexed by phi sector
+    int gpShift_;
+    std::vector<long long> offsetsPhi_;
+    // gp z: offset to unsigned r, sector z residuals in z lsb indexed by sectorEta * widthOffsetsZ_ + unsigned r
+    int offsetR_;
+    int widthOffsetsZ_;
+    std::vector<int> offsetsZ_;
+    // lf phi: shifts of stub phi, qOverPt * r and phiT w.r.t. common denominator 2^lfShift_
+    int lfShiftPhi_;
+    int lfShiftR_;
+    int lfShiftPhiT_;
+    int lfShift_;
+    // ht phiT: shifts of stub phi and qOverPt * r w.r.t. common denominator 2^htShift_
+    int htShiftPhi_;
+    int htShiftR_;
+    int htShift_;
+    // mht phiT: shifts of stub phi, fine qOverPt * r and cell offset w.r.t. common denominator 2^mhtShift_,
+    // phi residual is obtained by shifting by mhtShiftResid_
+    int mhtShiftPhi_;
+    int mhtShiftR_;
+    int mhtShiftOffset_;
+    int mhtShiftResid_;
+    int mhtShift_;
   };
 
   template<typename ...Ts>
@@ -137,7 +264,7 @@ namespace trackerTFP {
     Stub(const TTDTC::Frame& frame, const DataFormats* dataFormats, Process p);
     template<typename ...Others>
     Stub(const Stub<Others...>& stub, Ts... data);
-    Stub() {}
+    Stub() : dataFormats_(nullptr), p_(Process::x), frame_(), data_(), trackId_(0) {}
     ~Stub() {}
     explicit operator bool() const { return frame_.first.isNonnull(); }
     const DataFormats* dataFormats() const { return dataFormats_; }
@@ -146,10 +273,15 @@ namespace trackerTFP {
     const TTStubRef& ttStubRef() const { return frame_.first; }
     const TTDTC::BV& bv() const { return frame_.second; }
     int trackId() const { return trackId_; }
+    // digitised value of the index-th stub variable
+    int integer(int index) const { return dataFormats_->fields(p_)[index].integer(bv().to_ullong()); }
   protected:
     int width(Variable v) const { return dataFormats_->width(v, p_); }
     double base(Variable v) const { return dataFormats_->base(v, p_); }
     const DataFormat& format(Variable v) const { return dataFormats_->format(v, p_); }
+    // encodes bit accurate frame of derived stubs, called once their data is final, so that const stubs are
+    // immutable and may be read from concurrent tasks
+    void encode();
     const DataFormats* dataFormats_;
     Process p_;
     TTDTC::Frame frame_;
@@ -215,6 +347,92 @@ namespace trackerTFP {
     int qOverPt_;
   };
 
+  class StubLR : public Stub<double, double, double, int> {
+  public:
+    StubLR(const TTDTC::Frame& frame, const DataFormats* dataFormats);
+    ~StubLR(){}
+    double r() const { return std::get<0>(data_); };
+    // phi residual to fitted track
+    double phi() const { return std::get<1>(data_); };
+    // z residual to fitted track
+    double z() const { return std::get<2>(data_); };
+    int layer() const { return std::get<3>(data_); };
+  };
+
+  // compact track: digitised track parameter in its first frame, hit layer pattern and position of its stubs in the
+  // stub stream in its second frame
+  template<typename ...Ts>
+  class Track {
+  public:
+    // reads track starting at given frame of a track stream
+    Track(TTDTC::Stream::const_iterator frame, const DataFormats* dataFormats, Process p);
+    Track(const TTStubRef& ttStubRef, const DataFormats* dataFormats, Process p, const std::tuple<Ts...>& data,
+          int hitPattern, int begin, int size);
+    ~Track() {}
+    Process p() const { return p_; }
+    // appends track frames to given track stream
+    void put(TTDTC::Stream& stream) const { stream.insert(stream.end(), frames_.begin(), frames_.end()); }
+    // stub reference of first stub
+    const TTStubRef& ttStubRef() const { return frames_.front().first; }
+    // track parameter, ordered like DataFormats::tracks(p)
+    const std::tuple<Ts...>& data() const { return data_; }
+    int hitPattern() const { return hitPattern_; }
+    // position of first stub in the stub stream
+    int begin() const { return begin_; }
+    // number of stubs
+    int size() const { return size_; }
+    int end() const { return begin_ + size_; }
+  protected:
+    const DataFormats* dataFormats_;
+    Process p_;
+    std::array<TTDTC::Frame, DataFormats::numFramesTrack_> frames_;
+    std::tuple<Ts...> data_;
+    int hitPattern_;
+    int begin_;
+    int size_;
+  };
+
+  // track of a hough transform stage: sector and qOverPt, phiT cell
+  template<Process process>
+  class TrackCell : public Track<int, int, int, int> {
+  public:
+    TrackCell(TTDTC::Stream::const_iterator frame, const DataFormats* dataFormats) :
+      Track(frame, dataFormats, process) {}
+    TrackCell(const TTStubRef& ttStubRef, const DataFormats* dataFormats,
+              int sectorPhi, int sectorEta, int qOverPt, int phiT, int hitPattern, int begin, int size) :
+      Track(ttStubRef, dataFormats, process, {sectorPhi, sectorEta, qOverPt, phiT}, hitPattern, begin, size) {}
+    ~TrackCell(){}
+    int sectorPhi() const { return std::get<0>(data_); }
+    int sectorEta() const { return std::get<1>(data_); }
+    int qOverPt() const { return std::get<2>(data_); }
+    int phiT() const { return std::get<3>(data_); }
+  };
+
+  // track of a fit or filter stage: sector and helix parameter
+  template<Process process>
+  class TrackHelix : public Track<int, int, int, int, int, int> {
+  public:
+    TrackHelix(TTDTC::Stream::const_iterator frame, const DataFormats* dataFormats) :
+      Track(frame, dataFormats, process) {}
+    TrackHelix(const TTStubRef& ttStubRef, const DataFormats* dataFormats, int sectorPhi, int sectorEta,
+               int qOverPt, int phiT, int cot, int zT, int hitPattern, int begin, int size) :
+      Track(ttStubRef, dataFormats, process, {sectorPhi, sectorEta, qOverPt, phiT, cot, zT}, hitPattern, begin, size) {}
+    ~TrackHelix(){}
+    int sectorPhi() const { return std::get<0>(data_); }
+    int sectorEta() const { return std::get<1>(data_); }
+    int qOverPt() const { return std::get<2>(data_); }
+    int phiT() const { return std::get<3>(data_); }
+    int cot() const { return std::get<4>(data_); }
+    int zT() const { return std::get<5>(data_); }
+  };
+
+  typedef TrackCell<Process::lf> TrackLF;
+  typedef TrackHelix<Process::lr> TrackLR;
+  typedef TrackCell<Process::mht> TrackMHT;
+  typedef TrackHelix<Process::sf> TrackSF;
+  typedef TrackHelix<Process::kf> TrackKF;
+  typedef TrackHelix<Process::dr> TrackDR;
+
 } // namespace trackerTFP
 
 EVENTSETUP_DATA_DEFAULT_RECORD(trackerTFP::DataFormats, trackerTFP::DataFormatsRcd);
@@ -0,0 +1,78 @@
+#ifndef L1Trigger_TrackerTFP_DuplicateRemoval_h
+#define L1Trigger_TrackerTFP_DuplicateRemoval_h
+
+#include "L1Trigger/TrackerDTC/interface/Setup.h"
+#include "L1Trigger/TrackerTFP/interface/DataFormats.h"
+
+#include <vector>
+
+namespace trackerTFP {
+
+  // Class to remove duplicated KF tracks of a region, tracks are compared by hashing their digitised helix parameter
+  class DuplicateRemoval {
+  public:
+    DuplicateRemoval(const edm::ParameterSet& iConfig,
+                     const trackerDTC::Setup* setup,
+                     const DataFormats* dataFormats,
+                     int region);
+    ~DuplicateRemoval(){}
+
+    // drop tracks of previous event, allocated memory is kept
+    void clear();
+    // read in and organize input product
+    void consume(const TTDTC::Streams& stubs, const TTDTC::Streams& tracks);
+    // fill output products, tracks point to their stubs in the accepted stream of the same channel
+    void produce(TTDTC::Streams& accepted, TTDTC::Streams& tracks);
+
+  private:
+    // helix parameter of given track digitised into the cell size used to form candidates, never 0
+    unsigned long long key(int track) const;
+    // table slot holding given key or the empty slot where it would be stored
+    int find(unsigned long long key) const;
+    // stores given key, the oldest key is forgotten if the memory is full
+    void insert(unsigned long long key);
+    // removes key stored in given slot, keeps linear probing sequences intact
+    void erase(int slot);
+
+    //
+    const trackerDTC::Setup* setup_;
+    //
+    const DataFormats* dataFormats_;
+    //
+    int region_;
+    // number of tracks remembered
+    int depth_;
+    // exponents to digitise kf helix parameter into candidate cells
+    int shiftQoverPt_;
+    int shiftPhiT_;
+    int shiftCot_;
+    int shiftZT_;
+    // number of mht phiT cells per phi sector
+    int binsPerSector_;
+    // open addressing hash table of remembered keys, 0 marks an empty slot, size is power of 2
+    std::vector<unsigned long long> table_;
+    // number of bits used to address table slots
+    int widthTable_;
+    // remembered keys in insertion order, ring buffer of depth_ entries
+    std::vector<unsigned long long> memory_;
+    int head_;
+    int size_;
+    // per track input, stubs of track i are [begin_[i], begin_[i + 1])
+    std::vector<int> channel_;
+    std::vector<int> end_;
+    std::vector<int> sectorPhi_;
+    std::vector<int> sectorEta_;
+    std::vector<int> qOverPt_;
+    std::vector<int> phiT_;
+    std::vector<int> cot_;
+    std::vector<int> zT_;
+    std::vector<int> hitPattern_;
+    std::vector<int> begin_;
+    std::vector<TTDTC::Frame> frames_;
+    // track indices ordered by arrival
+    std::vector<int> order_;
+  };
+
+}
+
+#endif
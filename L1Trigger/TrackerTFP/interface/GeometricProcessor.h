@@ -3,9 +3,10 @@
 
 #include "L1Trigger/TrackerDTC/interface/Setup.h"
 #include "L1Trigger/TrackerTFP/interface/DataFormats.h"
+#include "L1Trigger/TrackerTFP/interface/Stubs.h"
+#include "L1Trigger/TrackerTFP/interface/Merger.h"
 
 #include <vector>
-#include <deque>
 
 namespace trackerTFP {
 
@@ -15,18 +16,21 @@ namespace trackerTFP {
     GeometricProcessor(const edm::ParameterSet& iConfig, const trackerDTC::Setup* setup_, const DataFormats* dataFormats, int region);
     ~GeometricProcessor(){}
 
+    // drop stubs of previous event, allocated memory is kept
+    void clear();
     // read in and organize input product
     void consume(const TTDTC& ttDTC);
     // fill output products
     void produce(TTDTC::Streams& accepted, TTDTC::Streams& lost);
 
   private:
-    // remove and return first element of deque, returns nullptr if empty
-    template<class T>
-    T* pop_front(std::deque<T*>& ts) const;
+    // route stubs of one sector, sectors are independent and may be processed concurrently
+    void produce(int sector, TTDTC::Streams& accepted, TTDTC::Streams& lost);
 
     //
     bool enableTruncation_;
+    // process sectors as concurrent tasks
+    bool enableParallel_;
     // 
     const trackerDTC::Setup* setup_;
     //
@@ -34,11 +38,17 @@ namespace trackerTFP {
     // 
     const int region_;
     // 
-    std::vector<StubPP> stubsPP_;
-    // 
-    std::vector<StubGP> stubsGP_;
-    // 
-    std::vector<std::vector<std::deque<StubPP*>>> input_;
+    StubsPP stubsPP_;
+    // GP stubs of all sectors, sector after sector
+    StubsGP stubsGP_;
+    // PP stubs ordered by arrival time, gaps are not stored
+    std::vector<Arrival> arrivals_;
+    // PP stubs per sector ordered by arrival time, gaps are not stored
+    std::vector<std::vector<Arrival>> input_;
+    // index of first GP stub per sector, last entry holds number of GP stubs
+    std::vector<int> begins_;
+    // input fifos and merger per sector
+    std::vector<Merger> mergers_;
   };
 
 }
@@ -0,0 +1,129 @@
+#ifndef L1Trigger_TrackerTFP_KalmanFilter_h
+#define L1Trigger_TrackerTFP_KalmanFilter_h
+
+#include "L1Trigger/TrackerDTC/interface/Setup.h"
+#include "L1Trigger/TrackerTFP/interface/DataFormats.h"
+
+#include <vector>
+
+namespace trackerTFP {
+
+  // Class to fit SF tracks of a region with a fixed point Kalman Filter, adding stubs layer by layer inside out
+  class KalmanFilter {
+  public:
+    KalmanFilter(const edm::ParameterSet& iConfig,
+                 const trackerDTC::Setup* setup,
+                 const DataFormats* dataFormats,
+                 int region);
+    ~KalmanFilter(){}
+
+    // drop tracks of previous event, allocated memory is kept
+    void clear();
+    // read in and organize input product
+    void consume(const TTDTC::Streams& stubs, const TTDTC::Streams& tracks);
+    // fill output products, tracks point to their stubs in the accepted stream of the same channel
+    void produce(TTDTC::Streams& accepted, TTDTC::Streams& tracks);
+
+  private:
+    // propagates all states of the region through all layers
+    void fit();
+    // resizes the state pool to given number of states, new states are filled by branch
+    void grow(int numStates);
+    // copies given state into given new state which is updated with given stub
+    void branch(int state, int added, int stub);
+    // updates states [begin, end) with their pending stub
+    void update(int begin, int end);
+    // 1 / r in given inverse base for r > 0, r is truncated to width bits to address the look up table
+    static long long invert(long long r, const std::vector<long long>& lut, int width, int shift);
+    // value * 2^-shift, floored
+    static long long convert(long long value, int shift) {
+      return shift >= 0 ? (value >= 0 ? value >> shift : ~(~value >> shift)) : value * (1LL << -shift);
+    }
+
+    //
+    const trackerDTC::Setup* setup_;
+    //
+    const DataFormats* dataFormats_;
+    //
+    int region_;
+    //
+    int numLayers_;
+    //
+    int maxStubsPerLayer_;
+    //
+    int maxLayers_;
+    // reciprocal look up tables, entry m holds 2^(2 * width) / (m + .5)
+    std::vector<long long> lutInvPhi_;
+    std::vector<long long> lutInvZ_;
+    // exponents relating base of r * inverse r to the look up table normalisation
+    int shiftInvR00_;
+    int shiftInvR11_;
+    // exponents converting products and summands into the bases of the kf intermediate variables
+    int shiftS00_, shiftS00C01_, shiftS01_, shiftS01C11_, shiftS12_, shiftS12C23_, shiftS13_, shiftS13C33_;
+    int shiftR00_, shiftR00v0_, shiftR00S01_, shiftR11_, shiftR11v1_, shiftR11S13_;
+    int shiftK00_, shiftK10_, shiftK21_, shiftK31_;
+    int shiftr0_, shiftr0m0_, shiftr0x1_, shiftr1_, shiftr1m1_, shiftr1x3_;
+    int shiftx0_, shiftx1_, shiftx2_, shiftx3_;
+    int shiftC00_, shiftC01_, shiftC11_, shiftC22_, shiftC23_, shiftC33_;
+    int shiftr02_, shiftr12_, shiftChi20_, shiftChi21_, shiftChi2r0_, shiftChi2r1_;
+    // exponents converting seed into stub z residual and track cells into kf track parameter
+    int shiftZT_;
+    int shiftCot_;
+    int shiftQoverPtKF_;
+    int shiftPhiTKF_;
+    int shiftCotKF_;
+    int shiftZTKF_;
+    // distance between chosenRofZ and chosenRofPhi in units of a r lsb and of half a r lsb
+    int leverR_;
+    long long leverZT_;
+    // cot and zT of eta sector centres in sf formats
+    std::vector<int> offsetsCot_;
+    std::vector<int> offsetsZT_;
+    // initial covariance
+    long long initC00_, initC11_, initC22_, initC33_;
+    // measurement variances in kf bases
+    long long v0_;
+    long long v1PS_;
+    long long v12S_;
+    // per track input
+    std::vector<int> channel_;
+    std::vector<int> sectorPhi_;
+    std::vector<int> sectorEta_;
+    std::vector<int> qOverPt_;
+    std::vector<int> phiT_;
+    std::vector<int> cot_;
+    std::vector<int> zT_;
+    // per track and layer number of stubs and stubs, index = (track * numLayers_ + layer) * maxStubsPerLayer_ + i
+    std::vector<int> layerSize_;
+    std::vector<int> layerStubs_;
+    // per stub frame, phi and z residual to seed, H matrix elements and z variance
+    std::vector<TTDTC::Frame> frames_;
+    std::vector<int> m0_;
+    std::vector<int> m1_;
+    std::vector<int> H00_;
+    std::vector<int> H12_;
+    std::vector<int> layer_;
+    std::vector<long long> v1_;
+    // state pool, states are identified by index and never removed during an event
+    std::vector<int> track_;
+    std::vector<int> stub_;
+    std::vector<int> numStubs_;
+    std::vector<int> skipped_;
+    std::vector<int> hitPattern_;
+    std::vector<int> open_;
+    std::vector<int> valid_;
+    // stubs per state, index = state * maxLayers_ + i
+    std::vector<int> stubs_;
+    // state helix parameter residuals w.r.t. input track, covariance and chi2
+    std::vector<long long> x0_, x1_, x2_, x3_;
+    std::vector<long long> C00_, C01_, C11_, C22_, C23_, C33_;
+    std::vector<long long> chi2_;
+    // update scratch per pending state, gathered stub inputs, intermediate results and inverse residual variances
+    std::vector<long long> H00s_, H12s_, m0s_, m1s_, v1s_;
+    std::vector<long long> S00s_, S01s_, S12s_, S13s_, r0s_, r1s_;
+    std::vector<long long> invR00s_, invR11s_;
+  };
+
+}
+
+#endif
@@ -3,9 +3,10 @@
 
 #include "L1Trigger/TrackerDTC/interface/Setup.h"
 #include "L1Trigger/TrackerTFP/interface/DataFormats.h"
+#include "L1Trigger/TrackerTFP/interface/Stubs.h"
+#include "L1Trigger/TrackerTFP/interface/Merger.h"
 
 #include <vector>
-#include <set>
 #include <deque>
 
 namespace trackerTFP {
@@ -16,19 +17,30 @@ namespace trackerTFP {
     LinearFitter(const edm::ParameterSet& iConfig, const trackerDTC::Setup* setup, const DataFormats* dataFormats, int region);
     ~LinearFitter(){}
 
+    // drop stubs of previous event, allocated memory is kept
+    void clear();
     // read in and organize input product
     void consume(const TTDTC::Streams& streams);
-    // fill output products
-    void produce(TTDTC::Streams& accepted, TTDTC::Streams& lost);
+    // fill output products, tracks point to their stubs in the accepted stream of the same channel
+    void produce(TTDTC::Streams& accepted, TTDTC::Streams& lost, TTDTC::Streams& tracks);
 
   private:
-    // remove and return first element of deque, returns nullptr if empty
-    template<class T>
-    T* pop_front(std::deque<T*>& ts) const;
-    // associate stubs with qOverPt and phiT bins
-    void fillIn(std::deque<StubGP*>& inputSector, std::vector<StubLF*>& acceptedSector, std::vector<StubLF*>& lostSector, int qOverPt);
-    // identify tracks
-    void readOut(const std::vector<StubLF*>& acceptedSector, const std::vector<StubLF*>& lostSector, std::deque<StubLF*>& acceptedAll, std::deque<StubLF*>& lostAll) const;
+    // find tracks of one qOverPt bin, bins are independent and may be processed concurrently
+    void produce(int binQoverPt, TTDTC::Streams& accepted, TTDTC::Streams& lost, TTDTC::Streams& tracks);
+    // associate stubs with qOverPt and phiT bins using precomputed phiT candidates, one per stub of inputSector
+    void fillIn(const std::vector<Arrival>& inputSector,
+                const int* majors,
+                const int* minors,
+                std::vector<int>& acceptedSector,
+                std::vector<int>& lostSector,
+                int binQoverPt);
+    // identify tracks, position of first stub of each found track in acceptedAll is appended to tracksAll
+    void readOut(const std::vector<int>& acceptedSector,
+                 const std::vector<int>& lostSector,
+                 std::deque<int>& acceptedAll,
+                 std::deque<int>& lostAll,
+                 std::vector<int>& tracksAll,
+                 int binQoverPt) const;
     // identify lost tracks
     void analyze();
     // store tracks
@@ -36,6 +48,8 @@ namespace trackerTFP {
 
     //
     bool enableTruncation_;
+    // process qOverPt bins as concurrent tasks
+    bool enableParallel_;
     // 
     const trackerDTC::Setup* setup_;
     //
@@ -47,11 +61,13 @@ namespace trackerTFP {
     //
     int region_;
     //
-    std::vector<StubGP> stubsGP_;
-    //
-    std::vector<StubLF> stubsLF_;
-    //
-    std::vector<std::vector<std::deque<StubGP*>>> input_;
+    StubsGP stubsGP_;
+    // LF stubs per qOverPt bin
+    std::vector<StubsLF> stubsLF_;
+    // GP stubs per qOverPt bin and sector ordered by arrival time, gaps are not stored
+    std::vector<std::vector<std::vector<Arrival>>> input_;
+    // per qOverPt bin fifo for stubs of minor candidates (channel 0) merged with stubs of major candidates (channel 1)
+    std::vector<Merger> mergers_;
   };
 
 }
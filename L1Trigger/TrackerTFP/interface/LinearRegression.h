@@ -0,0 +1,111 @@
+#ifndef L1Trigger_TrackerTFP_LinearRegression_h
+#define L1Trigger_TrackerTFP_LinearRegression_h
+
+#include "L1Trigger/TrackerDTC/interface/Setup.h"
+#include "L1Trigger/TrackerTFP/interface/DataFormats.h"
+
+#include <vector>
+
+namespace trackerTFP {
+
+  // Class to fit LF tracks of a region in r-phi and r-z by linear regression with iterative outlier removal
+  class LinearRegression {
+  public:
+    LinearRegression(const edm::ParameterSet& iConfig,
+                     const trackerDTC::Setup* setup,
+                     const DataFormats* dataFormats,
+                     int region);
+    ~LinearRegression(){}
+
+    // drop tracks of previous event, allocated memory is kept
+    void clear();
+    // read in and organize input product
+    void consume(const TTDTC::Streams& stubs, const TTDTC::Streams& tracks);
+    // fill output products, tracks point to their stubs in the accepted stream of the same channel
+    void produce(TTDTC::Streams& accepted, TTDTC::Streams& tracks);
+
+  private:
+    // fits all tracks of the region at once, stubs are stored slot major so that track loops read contiguous memory
+    void fit();
+    // calculates regression sums of active stubs and hit layer patterns of all tracks
+    void sums();
+    // calculates fit parameter and finds per track the stub with largest normalised residual
+    void residuals();
+    // closes given track, stores digitised track parameter if valid and in range
+    void close(int track, bool valid);
+    // floor(cell * 2^shiftCell + num / den * 2^shiftNum) for den > 0
+    static int digitise(long long cell, int shiftCell, long long num, long long den, int shiftNum);
+    // floor(num / den) for den > 0
+    static long long floorDiv(long long num, long long den) { return num >= 0 ? num / den : ~(~num / den); }
+
+    //
+    const trackerDTC::Setup* setup_;
+    //
+    const DataFormats* dataFormats_;
+    //
+    int region_;
+    // fixed point precision of normalised residuals
+    static constexpr int widthScore_ = 10;
+    // residual cuts in units of half a phi or z lsb
+    long long residPhi_;
+    long long residZPS_;
+    long long residZ2S_;
+    // exponents to convert lf cells and fit results into lr formats
+    int shiftPhiT_;
+    int shiftInterceptPhi_;
+    int shiftQoverPt_;
+    int shiftSlopePhi_;
+    int shiftSlopeZ_;
+    int shiftInterceptZ_;
+    // distance between chosenRofZ and chosenRofPhi in units of half a r lsb
+    long long leverZT_;
+    // cot and zT of eta sector centres in lr formats
+    std::vector<int> offsetsCot_;
+    std::vector<int> offsetsZT_;
+    // number of tracks and stub slots of current event, slots are padded to the largest track
+    int numTracks_;
+    int numSlots_;
+    // per track input
+    std::vector<int> channel_;
+    std::vector<int> sectorPhi_;
+    std::vector<int> sectorEta_;
+    std::vector<int> qOverPt_;
+    std::vector<int> phiT_;
+    // per track status: 1 while outliers are removed, 0 if closed
+    std::vector<int> open_;
+    // per track result, valid tracks have enough (PS) layers and track parameter in range
+    std::vector<bool> valid_;
+    // per track regression sums, r-phi uses all stubs, r-z uses PS stubs only
+    std::vector<long long> n_, sumR_, sumRR_, sumPhi_, sumRPhi_;
+    std::vector<long long> nPS_, sumRPS_, sumRRPS_, sumZ_, sumRZ_;
+    // per track hit layer patterns of active stubs
+    std::vector<int> pattern_;
+    std::vector<int> patternPS_;
+    // per track fit results, intercepts and slopes times denominators
+    std::vector<long long> interceptPhi_, slopePhi_, denPhi_;
+    std::vector<long long> interceptZ_, slopeZ_, denZ_;
+    // per track residual cuts times denominators
+    std::vector<long long> cutPhi_, cutZPS_, cutZ2S_;
+    // per track stub slot and normalised residual of worst stub
+    std::vector<int> worst_;
+    std::vector<long long> score_;
+    // per track digitised lr track parameter
+    std::vector<int> qOverPtLR_;
+    std::vector<int> phiTLR_;
+    std::vector<int> cotLR_;
+    std::vector<int> zTLR_;
+    // per slot and track stub data in units of half a lsb, index = slot * numTracks_ + track, coordinates are stored
+    // with the width of the sums they enter
+    std::vector<TTStubRef> ttStubRefs_;
+    std::vector<long long> r_;
+    std::vector<long long> phi_;
+    std::vector<long long> z_;
+    std::vector<int> layer_;
+    std::vector<int> ps_;
+    // 1 if slot holds a stub which is not removed as outlier
+    std::vector<int> active_;
+  };
+
+}
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef L1Trigger_TrackerTFP_Merger_h
+#define L1Trigger_TrackerTFP_Merger_h
+
+#include "L1Trigger/TrackerTFP/interface/Stubs.h"
+
+#include <vector>
+
+namespace trackerTFP {
+
+  /*! \class  trackerTFP::Merger
+   *  \brief  Clock accurate emulation of N input channels feeding fifos of depth D,
+   *          merged into one output stream by priority arbitration (highest channel first).
+   *          Stubs are identified by index, fifos are ring buffers, occupancy is tracked by a bit mask.
+   */
+  class Merger {
+  public:
+    Merger(int numChannel, int depth, bool enableTruncation, int numFrames);
+    ~Merger() {}
+
+    // empties all fifos, statistics are kept
+    void clear();
+    // stores stub in fifo of given channel, on overflow the oldest stub of this fifo is moved to lost
+    void push(int channel, int stub, std::vector<int>& lost);
+    // removes and returns oldest stub of highest occupied channel, returns -1 if all fifos are empty
+    int pop();
+    // removes and returns oldest stub of given non empty channel
+    int pop(int channel);
+    bool empty() const { return occupancy_ == 0; }
+    bool empty(int channel) const { return size_[channel] == 0; }
+    // number of stubs stored in fifo of given channel
+    int size(int channel) const { return size_[channel]; }
+    // emulates clock ticks until all arrivals are processed and all fifos are drained, one stub out per tick.
+    // arrivals have to be ordered in time, feed(channel, stub, merger, lost) is called for every arrival
+    // and is expected to push into this merger. Stubs leaving after numFrames are lost if truncation is enabled.
+    template <typename Feed>
+    void run(const std::vector<Arrival>& arrivals, Feed feed, std::vector<int>& accepted, std::vector<int>& lost);
+    // statistics accumulated since construction or last resetStatistics call
+    int maxOccupancy(int channel) const { return maxOccupancy_[channel]; }
+    int numOverflows() const { return numOverflows_; }
+    int numTruncated() const { return numTruncated_; }
+    void resetStatistics();
+
+  private:
+    // doubles ring buffer capacity, only needed if fifos are not bounded by truncation
+    void grow();
+
+    // number of input channels
+    int numChannel_;
+    // fifo depth, a full fifo holds depth - 1 stubs
+    int depth_;
+    //
+    bool enableTruncation_;
+    // number of frames per time multiplexed period
+    int numFrames_;
+    // ring buffer size per channel, power of 2
+    int capacity_;
+    // ring buffers of all channels, capacity_ entries per channel
+    std::vector<int> buffer_;
+    // position of oldest stub per channel
+    std::vector<int> head_;
+    // number of stubs per channel
+    std::vector<int> size_;
+    // bit per non empty channel
+    Mask occupancy_;
+    // stubs leaving after numFrames
+    std::vector<int> truncated_;
+    // largest fifo occupancy per channel
+    std::vector<int> maxOccupancy_;
+    // number of stubs lost by fifo overflow
+    int numOverflows_;
+    // number of stubs lost by truncation
+    int numTruncated_;
+  };
+
+  template <typename Feed>
+  void Merger::run(const std::vector<Arrival>& arrivals,
+                   Feed feed,
+                   std::vector<int>& accepted,
+                   std::vector<int>& lost) {
+    clear();
+    auto arrival = arrivals.begin();
+    // each trip describes one clock tick, idle ticks with empty fifos are skipped
+    for (int tick = 0; arrival != arrivals.end() || !empty(); tick++) {
+      if (empty())
+        tick = arrival->tick_;
+      for (; arrival != arrivals.end() && arrival->tick_ == tick; arrival++)
+        feed(arrival->channel_, arrival->stub_, *this, lost);
+      const int stub = pop();
+      if (stub == -1)
+        continue;
+      if (enableTruncation_ && tick >= numFrames_)
+        truncated_.push_back(stub);
+      else
+        accepted.push_back(stub);
+    }
+    numTruncated_ += truncated_.size();
+    lost.insert(lost.end(), truncated_.begin(), truncated_.end());
+  }
+
+}  // namespace trackerTFP
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef L1Trigger_TrackerTFP_MiniHoughTransform_h
+#define L1Trigger_TrackerTFP_MiniHoughTransform_h
+
+#include "L1Trigger/TrackerDTC/interface/Setup.h"
+#include "L1Trigger/TrackerTFP/interface/DataFormats.h"
+#include "L1Trigger/TrackerTFP/interface/Merger.h"
+
+#include <vector>
+
+namespace trackerTFP {
+
+  // Class to refine LF candidates of a region into finer cells and to balance the load of the output channels
+  class MiniHoughTransform {
+  public:
+    MiniHoughTransform(const edm::ParameterSet& iConfig,
+                       const trackerDTC::Setup* setup,
+                       const DataFormats* dataFormats,
+                       int region);
+    ~MiniHoughTransform(){}
+
+    // drop stubs of previous event, allocated memory is kept
+    void clear();
+    // read in and organize input product
+    void consume(const TTDTC::Streams& stubs, const TTDTC::Streams& tracks);
+    // fill output products, tracks point to their stubs in the accepted stream of the same channel
+    void produce(TTDTC::Streams& accepted, TTDTC::Streams& lost, TTDTC::Streams& tracks);
+
+  private:
+    // finds fine candidates of given lf track, their stubs are sent serially through given channel
+    void fill(int channel, const TrackLF& trackLF, const TTDTC::Stream& stream, int& tick);
+    // emulates one dynamic load balancing step, tracks are moved between channels of a node to the least filled fifo
+    void balance(int step);
+    // bit accurate MHT stub
+    TTDTC::Frame frame(int stub) const;
+
+    //
+    bool enableTruncation_;
+    //
+    const trackerDTC::Setup* setup_;
+    //
+    const DataFormats* dataFormats_;
+    //
+    int region_;
+    //
+    int numChannel_;
+    // per dlb step and node the connected channels, a node connects numDLBChannel channels of given stride
+    std::vector<std::vector<std::vector<int>>> nodes_;
+    // per dlb node output fifos, reused for all steps
+    std::vector<Merger> mergers_;
+    // mht stubs, a lf stub appears once per fine cell it contributes to
+    std::vector<TTStubRef> ttStubRefs_;
+    std::vector<int> r_;
+    std::vector<int> phi_;
+    std::vector<int> z_;
+    std::vector<int> layer_;
+    std::vector<int> track_;
+    // mht tracks
+    std::vector<int> sectorPhi_;
+    std::vector<int> sectorEta_;
+    std::vector<int> qOverPt_;
+    std::vector<int> phiT_;
+    // per track dlb node output of current step, -1 if not yet routed
+    std::vector<int> route_;
+    // per channel stubs ordered in time, -1 marks gaps
+    std::vector<std::vector<int>> streams_;
+    // per channel output of current dlb step
+    std::vector<std::vector<int>> buffer_;
+    // per channel stubs lost by fifo overflow or truncation
+    std::vector<std::vector<int>> lost_;
+    // per stub of the lf track being filled and fine qOverPt bin fine cell, -1 if outside of lf cell, and phi residual
+    std::vector<int> cells_;
+    std::vector<int> phis_;
+    // per fine cell of the lf track being filled hit layer pattern
+    std::vector<unsigned int> patterns_;
+  };
+
+}
+
+#endif
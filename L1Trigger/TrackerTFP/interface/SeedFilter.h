@@ -0,0 +1,79 @@
+#ifndef L1Trigger_TrackerTFP_SeedFilter_h
+#define L1Trigger_TrackerTFP_SeedFilter_h
+
+#include "L1Trigger/TrackerDTC/interface/Setup.h"
+#include "L1Trigger/TrackerTFP/interface/DataFormats.h"
+
+#include <vector>
+#include <utility>
+
+namespace trackerTFP {
+
+  // Class to form r-z seeds from PS stub pairs of MHT candidates of a region and to drop stubs inconsistent with them
+  class SeedFilter {
+  public:
+    SeedFilter(const edm::ParameterSet& iConfig,
+               const trackerDTC::Setup* setup,
+               const DataFormats* dataFormats,
+               int region);
+    ~SeedFilter(){}
+
+    // drop tracks of previous event, allocated memory is kept
+    void clear();
+    // read in and organize input product
+    void consume(const TTDTC::Streams& stubs, const TTDTC::Streams& tracks);
+    // fill output products, tracks point to their stubs in the accepted stream of the same channel
+    void produce(TTDTC::Streams& accepted, TTDTC::Streams& tracks);
+
+  private:
+    // finds seed of given track with most consistent layers, returns its hit layer pattern or 0 if none is found
+    int filter(int track, int& seed1, int& seed2) const;
+    // digitises seed formed by given stubs, returns false if seed is out of range or misses the beam window
+    bool seed(int seed1, int seed2, int sectorEta, int& cot, int& zT) const;
+    // true if stub is consistent in r-z with seed formed by given stubs
+    bool consistent(int stub, int seed1, int seed2) const;
+    // floor(cell * 2^shiftCell + num / den * 2^shiftNum) for den > 0
+    static int digitise(long long cell, int shiftCell, long long num, long long den, int shiftNum);
+    // floor(num / den) for den > 0
+    static long long floorDiv(long long num, long long den) { return num >= 0 ? num / den : ~(~num / den); }
+
+    //
+    const trackerDTC::Setup* setup_;
+    //
+    const DataFormats* dataFormats_;
+    //
+    int region_;
+    // per PS layer pattern all layer pairs to seed from, inner layers first
+    std::vector<std::vector<std::pair<int, int>>> seedPairs_;
+    // stub consistency windows in units of half a z lsb
+    long long residZPS_;
+    long long residZ2S_;
+    // beam window in units of half a z lsb
+    long long beamWindowZ_;
+    // chosenRofZ and beam line w.r.t. chosenRofPhi in units of half a r lsb
+    long long leverZT_;
+    long long leverZ0_;
+    // exponents to convert seed slopes and intercepts into sf formats
+    int shiftCot_;
+    int shiftZT_;
+    // cot and zT of eta sector centres in sf formats
+    std::vector<int> offsetsCot_;
+    std::vector<int> offsetsZT_;
+    // per track input, stubs of track i are [begin_[i], begin_[i + 1])
+    std::vector<int> channel_;
+    std::vector<int> sectorPhi_;
+    std::vector<int> sectorEta_;
+    std::vector<int> qOverPt_;
+    std::vector<int> phiT_;
+    std::vector<int> begin_;
+    // per stub input, r and z in units of half a lsb
+    std::vector<TTDTC::Frame> frames_;
+    std::vector<int> r_;
+    std::vector<int> z_;
+    std::vector<int> layer_;
+    std::vector<int> ps_;
+  };
+
+}
+
+#endif
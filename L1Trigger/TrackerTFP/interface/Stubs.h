@@ -0,0 +1,142 @@
+#ifndef L1Trigger_TrackerTFP_Stubs_h
+#define L1Trigger_TrackerTFP_Stubs_h
+
+#include "L1Trigger/TrackerTFP/interface/DataFormats.h"
+
+#include <vector>
+
+namespace trackerTFP {
+
+  // bit mask over sectors or qOverPt bins
+  typedef unsigned long long Mask;
+
+  // stub (index) arriving at given clock tick on given input channel
+  struct Arrival {
+    int tick_;
+    int channel_;
+    int stub_;
+  };
+
+  // Structure of arrays holding digitised PP stubs, stubs are identified by their index
+  class StubsPP {
+  public:
+    StubsPP(const DataFormats* dataFormats);
+    ~StubsPP() {}
+    // adds stub extracted from DTC frame, sector masks are filled by fillSectors
+    void emplace_back(const TTDTC::Frame& frame);
+    // calculates sector masks of all stubs in one batch
+    void fillSectors();
+    void reserve(int n);
+    void clear();
+    int size() const { return ttStubRefs_.size(); }
+    const TTStubRef& ttStubRef(int i) const { return ttStubRefs_[i]; }
+    int r(int i) const { return r_[i]; }
+    int phi(int i) const { return phi_[i]; }
+    int z(int i) const { return z_[i]; }
+    int layer(int i) const { return layer_[i]; }
+    int qOverPtMin(int i) const { return qOverPtMin_[i]; }
+    int qOverPtMax(int i) const { return qOverPtMax_[i]; }
+    // sectors (sectorEta * numSectorsPhi + sectorPhi) this stub belongs to
+    Mask sectors(int i) const { return sectors_[i]; }
+    bool inSector(int i, int sector) const { return (sectors_[i] >> sector) & 1; }
+
+  private:
+    const DataFormats* dataFormats_;
+    // sum of 2^(sectorEta * numSectorsPhi) over all eta sectors below index, used to replicate phi sector patterns
+    std::vector<Mask> patternsEta_;
+    std::vector<TTStubRef> ttStubRefs_;
+    std::vector<int> r_;
+    std::vector<int> phi_;
+    std::vector<int> z_;
+    std::vector<int> layer_;
+    std::vector<int> qOverPtMin_;
+    std::vector<int> qOverPtMax_;
+    // phi sector pattern and eta sector range as received
+    std::vector<Mask> sectorsPhi_;
+    std::vector<int> sectorEtaMin_;
+    std::vector<int> sectorEtaMax_;
+    std::vector<Mask> sectors_;
+  };
+
+  // Structure of arrays holding digitised GP stubs, stubs are identified by their index
+  class StubsGP {
+  public:
+    StubsGP(const DataFormats* dataFormats);
+    ~StubsGP() {}
+    // adds stub extracted from GP frame
+    void emplace_back(const TTDTC::Frame& frame, int sectorPhi, int sectorEta);
+    // adds stub transformed from i-th PP stub into given sector
+    void emplace_back(const StubsPP& stubs, int i, int sectorPhi, int sectorEta);
+    // adds all arriving PP stubs of all sectors, sector after sector, transformation runs as one batch
+    void emplace_back(const StubsPP& stubs, const std::vector<std::vector<Arrival>>& arrivals);
+    void reserve(int n);
+    void clear();
+    int size() const { return ttStubRefs_.size(); }
+    const TTStubRef& ttStubRef(int i) const { return ttStubRefs_[i]; }
+    int r(int i) const { return r_[i]; }
+    int phi(int i) const { return phi_[i]; }
+    int z(int i) const { return z_[i]; }
+    int layer(int i) const { return layer_[i]; }
+    int qOverPtMin(int i) const { return qOverPtMin_[i]; }
+    int qOverPtMax(int i) const { return qOverPtMax_[i]; }
+    int sectorPhi(int i) const { return sectorPhi_[i]; }
+    int sectorEta(int i) const { return sectorEta_[i]; }
+    // unsigned qOverPt bins this stub belongs to
+    Mask qOverPtBins(int i) const { return qOverPtBins_[i]; }
+    bool inQoverPtBin(int i, int qOverPtBin) const { return (qOverPtBins_[i] >> qOverPtBin) & 1; }
+    // bit accurate GP stub, encoded on request
+    TTDTC::Frame frame(int i) const;
+
+  private:
+    const DataFormats* dataFormats_;
+    int offsetQoverPt_;
+    std::vector<TTStubRef> ttStubRefs_;
+    std::vector<int> r_;
+    std::vector<int> phi_;
+    std::vector<int> z_;
+    std::vector<int> layer_;
+    std::vector<int> qOverPtMin_;
+    std::vector<int> qOverPtMax_;
+    std::vector<int> sectorPhi_;
+    std::vector<int> sectorEta_;
+    std::vector<Mask> qOverPtBins_;
+  };
+
+  // Structure of arrays holding digitised LF stubs, stubs are identified by their index
+  class StubsLF {
+  public:
+    StubsLF(const DataFormats* dataFormats);
+    ~StubsLF() {}
+    // adds stub transformed from i-th GP stub into given qOverPt and phiT bin
+    void emplace_back(const StubsGP& stubs, int i, int qOverPt, int phiT);
+    void reserve(int n);
+    void clear();
+    int size() const { return ttStubRefs_.size(); }
+    const TTStubRef& ttStubRef(int i) const { return ttStubRefs_[i]; }
+    int r(int i) const { return r_[i]; }
+    int phi(int i) const { return phi_[i]; }
+    int z(int i) const { return z_[i]; }
+    int layer(int i) const { return layer_[i]; }
+    int sectorPhi(int i) const { return sectorPhi_[i]; }
+    int sectorEta(int i) const { return sectorEta_[i]; }
+    int phiT(int i) const { return phiT_[i]; }
+    int qOverPt(int i) const { return qOverPt_[i]; }
+    // bit accurate LF stub, encoded on request
+    TTDTC::Frame frame(int i) const;
+
+  private:
+    const DataFormats* dataFormats_;
+    std::vector<TTStubRef> ttStubRefs_;
+    std::vector<int> r_;
+    std::vector<int> phi_;
+    std::vector<int> z_;
+    std::vector<int> layer_;
+    std::vector<int> sectorPhi_;
+    std::vector<int> sectorEta_;
+    std::vector<int> phiT_;
+    std::vector<int> qOverPt_;
+  };
+
+}  // namespace trackerTFP
+
+#endif
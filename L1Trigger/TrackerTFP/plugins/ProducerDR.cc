@@ -0,0 +1,15 @@
+#include "L1Trigger/TrackerTFP/plugins/ProducerStage.h"
+#include "L1Trigger/TrackerTFP/interface/DuplicateRemoval.h"
+
+namespace trackerTFP {
+
+  /*! \class  trackerTFP::ProducerDR
+   *  \brief  L1TrackTrigger Duplicate Removal emulator
+   *  \author Thomas Schuh, development Maziar Ghorbani
+   *  \date   2020, September
+   */
+  typedef ProducerStage<DuplicateRemoval, Process::dr, Process::kf> ProducerDR;
+
+} // namespace trackerTFP
+
+DEFINE_FWK_MODULE(trackerTFP::ProducerDR);
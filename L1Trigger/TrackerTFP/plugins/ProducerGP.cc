@@ -14,8 +14,11 @@
 #include "L1Trigger/TrackerTFP/interface/DataFormats.h"
 #include "L1Trigger/TrackerTFP/interface/GeometricProcessor.h"
 
+#include <tbb/parallel_for.h>
+
 #include <numeric>
 #include <string>
+#include <vector>
 
 using namespace std;
 using namespace edm;
@@ -50,14 +53,19 @@ namespace trackerTFP {
     ESGetToken<DataFormats, DataFormatsRcd> esGetTokenDataFormats_;
     // configuration
     ParameterSet iConfig_;
+    // process regions as concurrent tasks
+    bool enableParallel_;
     // helper classe to store configurations
     const Setup* setup_;
     // helper class to extract structured data from TTDTC::Frames
     const DataFormats* dataFormats_;
+    // Geometric Processors, one per region, reused for all events of a run
+    vector<GeometricProcessor> gps_;
   };
 
   ProducerGP::ProducerGP(const ParameterSet& iConfig) :
-    iConfig_(iConfig)
+    iConfig_(iConfig),
+    enableParallel_(iConfig.getParameter<bool>("EnableParallel"))
   {
     const string& label = iConfig.getParameter<string>("LabelDTC");
     const string& branchAccepted = iConfig.getParameter<string>("BranchAccepted");
@@ -82,6 +90,11 @@ namespace trackerTFP {
     if (iConfig_.getParameter<bool>("CheckHistory"))
       setup_->checkHistory(iRun.processHistory());
     dataFormats_ = &iSetup.getData(esGetTokenDataFormats_);
+    // engines depend on run dependent ES products
+    gps_.clear();
+    gps_.reserve(setup_->numRegions());
+    for (int region = 0; region < setup_->numRegions(); region++)
+      gps_.emplace_back(iConfig_, setup_, dataFormats_, region);
   }
 
   void ProducerGP::produce(Event& iEvent, const EventSetup& iSetup) {
@@ -93,14 +106,19 @@ namespace trackerTFP {
       Handle<TTDTC> handle;
       iEvent.getByToken<TTDTC>(edGetToken_, handle);
       const TTDTC& ttDTC = *handle.product();
-      for (int region = 0; region < setup_->numRegions(); region++) {
-        // object to route Stubs of one region to one stream per sector
-        GeometricProcessor gp(iConfig_, setup_, dataFormats_, region);
+      // regions are independent and fill disjoint slots of the pre-sized products
+      auto process = [this, &ttDTC, &accepted, &lost](int region) {
+        GeometricProcessor& gp = gps_[region];
         // read in and organize input product
         gp.consume(ttDTC);
         // fill output products
         gp.produce(accepted, lost);
-      }
+      };
+      if (enableParallel_)
+        tbb::parallel_for(0, (int)gps_.size(), process);
+      else
+        for (int region = 0; region < (int)gps_.size(); region++)
+          process(region);
     }
     // store products
     iEvent.emplace(edPutTokenAccepted_, move(accepted));
@@ -0,0 +1,15 @@
+#include "L1Trigger/TrackerTFP/plugins/ProducerStage.h"
+#include "L1Trigger/TrackerTFP/interface/KalmanFilter.h"
+
+namespace trackerTFP {
+
+  /*! \class  trackerTFP::ProducerKF
+   *  \brief  L1TrackTrigger Kalman Filter track fit emulator
+   *  \author Thomas Schuh, development Maziar Ghorbani
+   *  \date   2020, September
+   */
+  typedef ProducerStage<KalmanFilter, Process::kf, Process::sf> ProducerKF;
+
+} // namespace trackerTFP
+
+DEFINE_FWK_MODULE(trackerTFP::ProducerKF);
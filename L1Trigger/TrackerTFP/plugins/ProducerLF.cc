@@ -14,8 +14,11 @@
 #include "L1Trigger/TrackerTFP/interface/DataFormats.h"
 #include "L1Trigger/TrackerTFP/interface/LinearFitter.h"
 
+#include <tbb/parallel_for.h>
+
 #include <string>
 #include <numeric>
+#include <vector>
 
 using namespace std;
 using namespace edm;
@@ -44,28 +47,37 @@ namespace trackerTFP {
     EDPutTokenT<TTDTC::Streams> edPutTokenAccepted_;
     // ED output token for lost stubs
     EDPutTokenT<TTDTC::Streams> edPutTokenLost_;
+    // ED output token for accepted tracks
+    EDPutTokenT<TTDTC::Streams> edPutTokenTracks_;
     // Setup token
     ESGetToken<Setup, SetupRcd> esGetTokenSetup_;
     // DataFormats token
     ESGetToken<DataFormats, DataFormatsRcd> esGetTokenDataFormats_;
     // configuration
     ParameterSet iConfig_;
+    // process regions as concurrent tasks
+    bool enableParallel_;
     // helper class to store configurations
     const Setup* setup_;
     // helper class to extract structured data from TTDTC::Frames
     const DataFormats* dataFormats_;
+    // Linear Fitters, one per region, reused for all events of a run
+    vector<LinearFitter> lfs_;
   };
 
   ProducerLF::ProducerLF(const ParameterSet& iConfig) :
-    iConfig_(iConfig)
+    iConfig_(iConfig),
+    enableParallel_(iConfig.getParameter<bool>("EnableParallel"))
   {
     const string& label = iConfig.getParameter<string>("LabelGP");
     const string& branchAccepted = iConfig.getParameter<string>("BranchAccepted");
     const string& branchLost = iConfig.getParameter<string>("BranchLost");
+    const string& branchTracks = iConfig.getParameter<string>("BranchTracks");
     // book in- and output ED products
     edGetToken_ = consumes<TTDTC::Streams>(InputTag(label, branchAccepted));
     edPutTokenAccepted_ = produces<TTDTC::Streams>(branchAccepted);
     edPutTokenLost_ = produces<TTDTC::Streams>(branchLost);
+    edPutTokenTracks_ = produces<TTDTC::Streams>(branchTracks);
     // book ES products
     esGetTokenSetup_ = esConsumes<Setup, SetupRcd, Transition::BeginRun>();
     esGetTokenDataFormats_ = esConsumes<DataFormats, DataFormatsRcd, Transition::BeginRun>();
@@ -84,29 +96,41 @@ namespace trackerTFP {
       setup_->checkHistory(iRun.processHistory());
     // helper class to extract structured data from TTDTC::Frames
     dataFormats_ = &iSetup.getData(esGetTokenDataFormats_);
+    // engines depend on run dependent ES products
+    lfs_.clear();
+    lfs_.reserve(setup_->numRegions());
+    for (int region = 0; region < setup_->numRegions(); region++)
+      lfs_.emplace_back(iConfig_, setup_, dataFormats_, region);
   }
 
   void ProducerLF::produce(Event& iEvent, const EventSetup& iSetup) {
     // empty HT products
     TTDTC::Streams accepted(dataFormats_->numStreams(Process::lf));
     TTDTC::Streams lost(dataFormats_->numStreams(Process::lf));
+    TTDTC::Streams tracks(dataFormats_->numStreams(Process::lf));
     // read in DTC Product and produce TFP product
     if (setup_->configurationSupported()) {
       Handle<TTDTC::Streams> handle;
       iEvent.getByToken<TTDTC::Streams>(edGetToken_, handle);
       const TTDTC::Streams& streams = *handle.product();
-      for (int region = 0; region < setup_->numRegions(); region++) {
-        // object to find initial rough candidates in r-phi in a region
-        LinearFitter lf(iConfig_, setup_, dataFormats_, region);
+      // regions are independent and fill disjoint slots of the pre-sized products
+      auto process = [this, &streams, &accepted, &lost, &tracks](int region) {
+        LinearFitter& lf = lfs_[region];
         // read in and organize input product
         lf.consume(streams);
         // fill output products
-        lf.produce(accepted, lost);
-      }
+        lf.produce(accepted, lost, tracks);
+      };
+      if (enableParallel_)
+        tbb::parallel_for(0, (int)lfs_.size(), process);
+      else
+        for (int region = 0; region < (int)lfs_.size(); region++)
+          process(region);
     }
     // store products
     iEvent.emplace(edPutTokenAccepted_, move(accepted));
     iEvent.emplace(edPutTokenLost_, move(lost));
+    iEvent.emplace(edPutTokenTracks_, move(tracks));
   }
 
 } // namespace trackerTFP
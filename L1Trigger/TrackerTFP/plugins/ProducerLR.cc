@@ -0,0 +1,15 @@
+#include "L1Trigger/TrackerTFP/plugins/ProducerStage.h"
+#include "L1Trigger/TrackerTFP/interface/LinearRegression.h"
+
+namespace trackerTFP {
+
+  /*! \class  trackerTFP::ProducerLR
+   *  \brief  L1TrackTrigger Linear Regression track fit emulator
+   *  \author Thomas Schuh, development Maziar Ghorbani
+   *  \date   2020, September
+   */
+  typedef ProducerStage<LinearRegression, Process::lr, Process::lf> ProducerLR;
+
+} // namespace trackerTFP
+
+DEFINE_FWK_MODULE(trackerTFP::ProducerLR);
@@ -0,0 +1,15 @@
+#include "L1Trigger/TrackerTFP/plugins/ProducerStage.h"
+#include "L1Trigger/TrackerTFP/interface/MiniHoughTransform.h"
+
+namespace trackerTFP {
+
+  /*! \class  trackerTFP::ProducerMHT
+   *  \brief  L1TrackTrigger Mini Hough Transform emulator
+   *  \author Thomas Schuh, development Maziar Ghorbani
+   *  \date   2020, September
+   */
+  typedef ProducerStage<MiniHoughTransform, Process::mht, Process::lf> ProducerMHT;
+
+} // namespace trackerTFP
+
+DEFINE_FWK_MODULE(trackerTFP::ProducerMHT);
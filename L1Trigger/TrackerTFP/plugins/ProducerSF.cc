@@ -0,0 +1,15 @@
+#include "L1Trigger/TrackerTFP/plugins/ProducerStage.h"
+#include "L1Trigger/TrackerTFP/interface/SeedFilter.h"
+
+namespace trackerTFP {
+
+  /*! \class  trackerTFP::ProducerSF
+   *  \brief  L1TrackTrigger Seed Filter emulator
+   *  \author Thomas Schuh, development Maziar Ghorbani
+   *  \date   2020, September
+   */
+  typedef ProducerStage<SeedFilter, Process::sf, Process::mht> ProducerSF;
+
+} // namespace trackerTFP
+
+DEFINE_FWK_MODULE(trackerTFP::ProducerSF);
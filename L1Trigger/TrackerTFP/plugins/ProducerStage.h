@@ -0,0 +1,160 @@
+#ifndef L1Trigger_TrackerTFP_ProducerStage_h
+#define L1Trigger_TrackerTFP_ProducerStage_h
+
+#include "FWCore/Framework/interface/stream/EDProducer.h"
+#include "FWCore/Framework/interface/Run.h"
+#include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/MakerMacros.h"
+#include "FWCore/Utilities/interface/EDGetToken.h"
+#include "FWCore/Utilities/interface/EDPutToken.h"
+#include "FWCore/Utilities/interface/ESGetToken.h"
+#include "FWCore/Utilities/interface/InputTag.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "DataFormats/Common/interface/Handle.h"
+
+#include "L1Trigger/TrackerDTC/interface/Setup.h"
+#include "L1Trigger/TrackerTFP/interface/DataFormats.h"
+
+#include <tbb/parallel_for.h>
+
+#include <array>
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace trackerTFP {
+
+  /*! \class  trackerTFP::ProducerStage
+   *  \brief  Runs one track finding stage, which reads stubs and tracks of the previous stage, with one Engine per
+   *          region. The mht stage additionally produces lost stubs.
+   *  \author Thomas Schuh, development Maziar Ghorbani
+   *  \date   2020, September
+   */
+  template<typename Engine, Process p, Process in>
+  class ProducerStage : public edm::stream::EDProducer<> {
+  public:
+    explicit ProducerStage(const edm::ParameterSet&);
+    ~ProducerStage() override {}
+
+  private:
+    virtual void beginRun(const edm::Run&, const edm::EventSetup&) override;
+    virtual void produce(edm::Event&, const edm::EventSetup&) override;
+    virtual void endJob() {}
+
+    // engines of stages with lost stubs fill an additional product
+    static constexpr bool lost_ = p == Process::mht;
+    // name of parameter holding the module label of the producer of given process
+    static constexpr std::array<const char*, +Process::end> labels_ = {{
+      "", "LabelDTC", "LabelDTC", "LabelGP", "LabelLF", "LabelLR", "LabelMHT", "LabelSF", "LabelKF", "LabelDR"
+    }};
+
+    // ED input token of stubs of the previous stage
+    edm::EDGetTokenT<TTDTC::Streams> edGetTokenStubs_;
+    // ED input token of tracks of the previous stage
+    edm::EDGetTokenT<TTDTC::Streams> edGetTokenTracks_;
+    // ED output token for accepted stubs
+    edm::EDPutTokenT<TTDTC::Streams> edPutTokenAccepted_;
+    // ED output token for lost stubs
+    edm::EDPutTokenT<TTDTC::Streams> edPutTokenLost_;
+    // ED output token for accepted tracks
+    edm::EDPutTokenT<TTDTC::Streams> edPutTokenTracks_;
+    // Setup token
+    edm::ESGetToken<trackerDTC::Setup, trackerDTC::SetupRcd> esGetTokenSetup_;
+    // DataFormats token
+    edm::ESGetToken<DataFormats, DataFormatsRcd> esGetTokenDataFormats_;
+    // configuration
+    edm::ParameterSet iConfig_;
+    // process regions as concurrent tasks
+    bool enableParallel_;
+    // helper class to store configurations
+    const trackerDTC::Setup* setup_;
+    // helper class to extract structured data from TTDTC::Frames
+    const DataFormats* dataFormats_;
+    // engines, one per region, reused for all events of a run
+    std::vector<Engine> engines_;
+  };
+
+  template<typename Engine, Process p, Process in>
+  ProducerStage<Engine, p, in>::ProducerStage(const edm::ParameterSet& iConfig) :
+    iConfig_(iConfig),
+    enableParallel_(iConfig.getParameter<bool>("EnableParallel"))
+  {
+    const std::string& label = iConfig.getParameter<std::string>(labels_[+in]);
+    const std::string& branchAccepted = iConfig.getParameter<std::string>("BranchAccepted");
+    const std::string& branchLost = iConfig.getParameter<std::string>("BranchLost");
+    const std::string& branchTracks = iConfig.getParameter<std::string>("BranchTracks");
+    // book in- and output ED products
+    edGetTokenStubs_ = consumes<TTDTC::Streams>(edm::InputTag(label, branchAccepted));
+    edGetTokenTracks_ = consumes<TTDTC::Streams>(edm::InputTag(label, branchTracks));
+    edPutTokenAccepted_ = produces<TTDTC::Streams>(branchAccepted);
+    if constexpr(lost_)
+      edPutTokenLost_ = produces<TTDTC::Streams>(branchLost);
+    edPutTokenTracks_ = produces<TTDTC::Streams>(branchTracks);
+    // book ES products
+    esGetTokenSetup_ = esConsumes<trackerDTC::Setup, trackerDTC::SetupRcd, edm::Transition::BeginRun>();
+    esGetTokenDataFormats_ = esConsumes<DataFormats, DataFormatsRcd, edm::Transition::BeginRun>();
+    // initial ES products
+    setup_ = nullptr;
+    dataFormats_ = nullptr;
+  }
+
+  template<typename Engine, Process p, Process in>
+  void ProducerStage<Engine, p, in>::beginRun(const edm::Run& iRun, const edm::EventSetup& iSetup) {
+    // helper class to store configurations
+    setup_ = &iSetup.getData(esGetTokenSetup_);
+    if (!setup_->configurationSupported())
+      return;
+    // check process history if desired
+    if (iConfig_.getParameter<bool>("CheckHistory"))
+      setup_->checkHistory(iRun.processHistory());
+    // helper class to extract structured data from TTDTC::Frames
+    dataFormats_ = &iSetup.getData(esGetTokenDataFormats_);
+    // engines depend on run dependent ES products
+    engines_.clear();
+    engines_.reserve(setup_->numRegions());
+    for (int region = 0; region < setup_->numRegions(); region++)
+      engines_.emplace_back(iConfig_, setup_, dataFormats_, region);
+  }
+
+  template<typename Engine, Process p, Process in>
+  void ProducerStage<Engine, p, in>::produce(edm::Event& iEvent, const edm::EventSetup& iSetup) {
+    // empty products
+    TTDTC::Streams accepted(dataFormats_->numStreams(p));
+    TTDTC::Streams lost(lost_ ? dataFormats_->numStreams(p) : 0);
+    TTDTC::Streams tracks(dataFormats_->numStreams(p));
+    // read in product of previous stage and produce product of this stage
+    if (setup_->configurationSupported()) {
+      edm::Handle<TTDTC::Streams> handleStubs;
+      iEvent.getByToken<TTDTC::Streams>(edGetTokenStubs_, handleStubs);
+      edm::Handle<TTDTC::Streams> handleTracks;
+      iEvent.getByToken<TTDTC::Streams>(edGetTokenTracks_, handleTracks);
+      const TTDTC::Streams& stubs = *handleStubs.product();
+      const TTDTC::Streams& tracksIn = *handleTracks.product();
+      // regions are independent and fill disjoint slots of the pre-sized products
+      auto process = [this, &stubs, &tracksIn, &accepted, &lost, &tracks](int region) {
+        Engine& engine = engines_[region];
+        // read in and organize input product
+        engine.consume(stubs, tracksIn);
+        // fill output products
+        if constexpr(lost_)
+          engine.produce(accepted, lost, tracks);
+        else
+          engine.produce(accepted, tracks);
+      };
+      if (enableParallel_)
+        tbb::parallel_for(0, (int)engines_.size(), process);
+      else
+        for (int region = 0; region < (int)engines_.size(); region++)
+          process(region);
+    }
+    // store products
+    iEvent.emplace(edPutTokenAccepted_, std::move(accepted));
+    if constexpr(lost_)
+      iEvent.emplace(edPutTokenLost_, std::move(lost));
+    iEvent.emplace(edPutTokenTracks_, std::move(tracks));
+  }
+
+} // namespace trackerTFP
+
+#endif
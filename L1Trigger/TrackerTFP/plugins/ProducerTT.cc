@@ -0,0 +1,150 @@
+#include "FWCore/Framework/interface/stream/EDProducer.h"
+#include "FWCore/Framework/interface/Run.h"
+#include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/MakerMacros.h"
+#include "FWCore/Utilities/interface/EDGetToken.h"
+#include "FWCore/Utilities/interface/EDPutToken.h"
+#include "FWCore/Utilities/interface/ESGetToken.h"
+#include "FWCore/Utilities/interface/InputTag.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "DataFormats/Common/interface/Handle.h"
+#include "DataFormats/L1TrackTrigger/interface/TTTypes.h"
+
+#include "L1Trigger/TrackerDTC/interface/Setup.h"
+#include "L1Trigger/TrackerTFP/interface/DataFormats.h"
+
+#include <string>
+#include <vector>
+#include <utility>
+
+using namespace std;
+using namespace edm;
+using namespace trackerDTC;
+
+namespace trackerTFP {
+
+  /*! \class  trackerTFP::ProducerTT
+   *  \brief  Converts DR tracks into TTTracks
+   *  \author Thomas Schuh, development Maziar Ghorbani
+   *  \date   2020, September
+   */
+  class ProducerTT : public stream::EDProducer<> {
+  public:
+    explicit ProducerTT(const ParameterSet&);
+    ~ProducerTT() override {}
+
+  private:
+    typedef TTTrack<Ref_Phase2TrackerDigi_> TTTrackType;
+    virtual void beginRun(const Run&, const EventSetup&) override;
+    virtual void produce(Event&, const EventSetup&) override;
+    virtual void endJob() {}
+
+    // ED input token of dr stubs
+    EDGetTokenT<TTDTC::Streams> edGetTokenStubs_;
+    // ED input token of dr tracks
+    EDGetTokenT<TTDTC::Streams> edGetTokenTracks_;
+    // ED output token for TTTracks
+    EDPutTokenT<vector<TTTrackType>> edPutToken_;
+    // Setup token
+    ESGetToken<Setup, SetupRcd> esGetTokenSetup_;
+    // DataFormats token
+    ESGetToken<DataFormats, DataFormatsRcd> esGetTokenDataFormats_;
+    // configuration
+    ParameterSet iConfig_;
+    // helper class to store configurations
+    const Setup* setup_;
+    // helper class to extract structured data from TTDTC::Frames
+    const DataFormats* dataFormats_;
+  };
+
+  ProducerTT::ProducerTT(const ParameterSet& iConfig) :
+    iConfig_(iConfig)
+  {
+    const string& label = iConfig.getParameter<string>("LabelDR");
+    const string& branchAccepted = iConfig.getParameter<string>("BranchAccepted");
+    const string& branchTracks = iConfig.getParameter<string>("BranchTracks");
+    // book in- and output ED products
+    edGetTokenStubs_ = consumes<TTDTC::Streams>(InputTag(label, branchAccepted));
+    edGetTokenTracks_ = consumes<TTDTC::Streams>(InputTag(label, branchTracks));
+    edPutToken_ = produces<vector<TTTrackType>>(branchTracks);
+    // book ES products
+    esGetTokenSetup_ = esConsumes<Setup, SetupRcd, Transition::BeginRun>();
+    esGetTokenDataFormats_ = esConsumes<DataFormats, DataFormatsRcd, Transition::BeginRun>();
+    // initial ES products
+    setup_ = nullptr;
+    dataFormats_ = nullptr;
+  }
+
+  void ProducerTT::beginRun(const Run& iRun, const EventSetup& iSetup) {
+    // helper class to store configurations
+    setup_ = &iSetup.getData(esGetTokenSetup_);
+    if (!setup_->configurationSupported())
+      return;
+    // check process history if desired
+    if (iConfig_.getParameter<bool>("CheckHistory"))
+      setup_->checkHistory(iRun.processHistory());
+    // helper class to extract structured data from TTDTC::Frames
+    dataFormats_ = &iSetup.getData(esGetTokenDataFormats_);
+  }
+
+  void ProducerTT::produce(Event& iEvent, const EventSetup& iSetup) {
+    // empty TTTrack product
+    vector<TTTrackType> ttTracks;
+    // read in DR Product and produce TTTrack product
+    if (setup_->configurationSupported()) {
+      Handle<TTDTC::Streams> handleStubs;
+      iEvent.getByToken<TTDTC::Streams>(edGetTokenStubs_, handleStubs);
+      Handle<TTDTC::Streams> handleTracks;
+      iEvent.getByToken<TTDTC::Streams>(edGetTokenTracks_, handleTracks);
+      const TTDTC::Streams& stubs = *handleStubs.product();
+      const TTDTC::Streams& tracks = *handleTracks.product();
+      int numTracks(0);
+      for (const TTDTC::Stream& stream : tracks)
+        numTracks += stream.size() / DataFormats::numFramesTrack_;
+      ttTracks.reserve(numTracks);
+      const DataFormat& formatQoverPt = dataFormats_->format(Variable::qOverPt, Process::dr);
+      const DataFormat& formatPhiT = dataFormats_->format(Variable::phiT, Process::dr);
+      const DataFormat& formatCot = dataFormats_->format(Variable::cot, Process::dr);
+      const DataFormat& formatZT = dataFormats_->format(Variable::zT, Process::dr);
+      const int numChannel = dataFormats_->numChannel(Process::dr);
+      for (int channel = 0; channel < (int)tracks.size(); channel++) {
+        const int region = channel / numChannel;
+        const TTDTC::Stream& stream = stubs[channel];
+        const TTDTC::Stream& streamTracks = tracks[channel];
+        for (auto frame = streamTracks.begin(); frame != streamTracks.end(); frame += DataFormats::numFramesTrack_) {
+          if (frame->first.isNull())
+            continue;
+          const TrackDR track(frame, dataFormats_);
+          // qOverPt is given in units of dphi / dr, phiT w.r.t. phi sector centre at chosenRofPhi
+          const double qOverPt = formatQoverPt.floating(track.qOverPt());
+          const double phiRegion = region * setup_->baseRegion();
+          const double phiSector = phiRegion + (track.sectorPhi() - .5) * setup_->baseSector();
+          const double phiT = formatPhiT.floating(track.phiT()) + phiSector;
+          const double phi0 = deltaPhi(phiT + qOverPt * setup_->chosenRofPhi());
+          const double cot = formatCot.floating(track.cot());
+          const double z0 = formatZT.floating(track.zT()) - cot * setup_->chosenRofZ();
+          vector<TTStubRef> ttStubRefs;
+          ttStubRefs.reserve(track.size());
+          for (int stub = track.begin(); stub < track.end(); stub++)
+            ttStubRefs.push_back(stream[stub].first);
+          // no chi2 nor MVA is provided by the kf emulation
+          ttTracks.emplace_back(2. * qOverPt, phi0, cot, z0, 0., 0., 0., 0., 0., track.hitPattern(), 4,
+                                setup_->bField());
+          TTTrackType& ttTrack = ttTracks.back();
+          ttTrack.setStubRefs(move(ttStubRefs));
+          ttTrack.setPhiSector(region);
+          ttTrack.setEtaSector(track.sectorEta());
+        }
+      }
+      // track words are packed in a separate pass once the collection is complete
+      for (TTTrackType& ttTrack : ttTracks)
+        ttTrack.setTrackWordBits();
+    }
+    // store products
+    iEvent.emplace(edPutToken_, move(ttTracks));
+  }
+
+} // namespace trackerTFP
+
+DEFINE_FWK_MODULE(trackerTFP::ProducerTT);
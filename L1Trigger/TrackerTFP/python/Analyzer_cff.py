@@ -6,3 +6,10 @@ from L1Trigger.TrackerTFP.Producer_cfi import TrackerTFPProducer_params
 
 TrackerTFPAnalyzerGP = cms.EDAnalyzer( 'trackerTFP::AnalyzerGP', TrackerTFPAnalyzer_params, TrackerTFPProducer_params )
 TrackerTFPAnalyzerLF = cms.EDAnalyzer( 'trackerTFP::AnalyzerLF', TrackerTFPAnalyzer_params, TrackerTFPProducer_params )
+TrackerTFPAnalyzerLR = cms.EDAnalyzer( 'trackerTFP::AnalyzerLR', TrackerTFPAnalyzer_params, TrackerTFPProducer_params )
+TrackerTFPAnalyzerMHT = cms.EDAnalyzer( 'trackerTFP::AnalyzerMHT', TrackerTFPAnalyzer_params, TrackerTFPProducer_params )
+TrackerTFPAnalyzerSF = cms.EDAnalyzer( 'trackerTFP::AnalyzerSF', TrackerTFPAnalyzer_params, TrackerTFPProducer_params )
+TrackerTFPAnalyzerKF = cms.EDAnalyzer( 'trackerTFP::AnalyzerKF', TrackerTFPAnalyzer_params, TrackerTFPProducer_params )
+TrackerTFPAnalyzerDR = cms.EDAnalyzer( 'trackerTFP::AnalyzerDR', TrackerTFPAnalyzer_params, TrackerTFPProducer_params )
+TrackerTFPAnalyzerTT = cms.EDAnalyzer( 'trackerTFP::AnalyzerTT', TrackerTFPAnalyzer_params, TrackerTFPProducer_params )
+TrackerTFPAnalyzerDataFormats = cms.EDAnalyzer( 'trackerTFP::AnalyzerDataFormats', TrackerTFPAnalyzer_params, TrackerTFPProducer_params )
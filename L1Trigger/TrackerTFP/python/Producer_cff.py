@@ -1,9 +1,15 @@
 # Modify
 import FWCore.ParameterSet.Config as cms
 
-from L1Trigger.TrackerDTC.ProducerES_cff import TrackTriggerSetup
+from L1Trigger.TrackerDTC.ProducerES_cff import TrackTriggerSetup, TrackTriggerSetupGeometry
 from L1Trigger.TrackerTFP.Producer_cfi import TrackerTFPProducer_params
 from L1Trigger.TrackerTFP.ProducerES_cff import TrackTriggerDataFormats
 
 TrackerTFPProducerGP = cms.EDProducer( 'trackerTFP::ProducerGP', TrackerTFPProducer_params )
 TrackerTFPProducerLF = cms.EDProducer( 'trackerTFP::ProducerLF', TrackerTFPProducer_params )
+TrackerTFPProducerLR = cms.EDProducer( 'trackerTFP::ProducerLR', TrackerTFPProducer_params )
+TrackerTFPProducerMHT = cms.EDProducer( 'trackerTFP::ProducerMHT', TrackerTFPProducer_params )
+TrackerTFPProducerSF = cms.EDProducer( 'trackerTFP::ProducerSF', TrackerTFPProducer_params )
+TrackerTFPProducerKF = cms.EDProducer( 'trackerTFP::ProducerKF', TrackerTFPProducer_params )
+TrackerTFPProducerDR = cms.EDProducer( 'trackerTFP::ProducerDR', TrackerTFPProducer_params )
+TrackerTFPProducerTT = cms.EDProducer( 'trackerTFP::ProducerTT', TrackerTFPProducer_params )
@@ -6,10 +6,17 @@ TrackerTFPProducer_params = cms.PSet (
   LabelDTC         = cms.string( "TrackerDTCProducer"    ), #
   LabelGP          = cms.string( "TrackerTFPProducerGP"  ), #
   LabelLF          = cms.string( "TrackerTFPProducerLF"  ), #
+  LabelLR          = cms.string( "TrackerTFPProducerLR"  ), #
+  LabelMHT         = cms.string( "TrackerTFPProducerMHT" ), #
+  LabelSF          = cms.string( "TrackerTFPProducerSF"  ), #
+  LabelKF          = cms.string( "TrackerTFPProducerKF"  ), #
+  LabelDR          = cms.string( "TrackerTFPProducerDR"  ), #
+  LabelTT          = cms.string( "TrackerTFPProducerTT"  ), #
   BranchAccepted   = cms.string( "StubAccepted"  ),         # branch for prodcut with passed stubs
   BranchLost       = cms.string( "StubLost"      ),         # branch for prodcut with lost stubs
   BranchTracks     = cms.string( "TrackAccepted" ),         # branch for prodcut with passed track information
   CheckHistory     = cms.bool  ( True  ),                   # checks if input sample production is configured as current process
-  EnableTruncation = cms.bool  ( True  )                    # enable emulation of truncation, lost stubs are filled in BranchLost
+  EnableTruncation = cms.bool  ( True  ),                   # enable emulation of truncation, lost stubs are filled in BranchLost
+  EnableParallel   = cms.bool  ( False )                    # run regions and GP sectors or LF qOverPt bins as concurrent tasks
 
 )
@@ -1,10 +1,12 @@
 #include "L1Trigger/TrackerTFP/interface/DataFormats.h"
+#include "FWCore/Utilities/interface/Exception.h"
 
 #include <vector>
 #include <cmath>
 #include <tuple>
 #include <iterator>
 #include <algorithm>
+#include <string>
 
 using namespace std;
 using namespace trackerDTC;
@@ -14,8 +16,19 @@ namespace trackerTFP {
   DataFormats::DataFormats() :
     numDataFormats_(0),
     formats_(+Variable::end, std::vector<DataFormat*>(+Process::end, nullptr)),
+    fields_(+Process::end),
     numUnusedBits_(+Process::end, TTBV::S),
-    numChannel_(+Process::end, 0)
+    numChannel_(+Process::end, 0),
+    gpShift_(0),
+    offsetR_(0),
+    widthOffsetsZ_(0),
+    lfShiftPhi_(0),
+    lfShiftR_(0),
+    lfShiftPhiT_(0),
+    lfShift_(0),
+    htShiftPhi_(0),
+    htShiftR_(0),
+    htShift_(0)
   {
     setup_ = nullptr;
     countFormats();
@@ -39,10 +52,18 @@ namespace trackerTFP {
     for (const Process p : Processes)
       for (const Variable v : stubs_[+p])
         numUnusedBits_[+p] -= formats_[+v][+p] ? formats_[+v][+p]->width() : 0;
+    fillFields();
+    checkTracks();
+    fillIntegerDomain();
     numChannel_[+Process::dtc] = setup_->numDTCsPerRegion();
     numChannel_[+Process::pp] = setup_->numDTCsPerTFP();
     numChannel_[+Process::gp] = setup_->numSectors();
     numChannel_[+Process::lf] = setup_->htNumBinsQoverPt();
+    numChannel_[+Process::lr] = setup_->htNumBinsQoverPt();
+    numChannel_[+Process::mht] = setup_->htNumBinsQoverPt();
+    numChannel_[+Process::sf] = setup_->htNumBinsQoverPt();
+    numChannel_[+Process::kf] = setup_->htNumBinsQoverPt();
+    numChannel_[+Process::dr] = setup_->htNumBinsQoverPt();
     transform(numChannel_.begin(), numChannel_.end(), back_inserter(numStreams_), [this](int channel){ return channel * setup_->numRegions(); });
   }
 
@@ -67,33 +88,198 @@ namespace trackerTFP {
       fillFormats<v, p, ++it>();
   }
 
+  // stub variables are packed msb first, the last variable of a stub occupies the least significant bits
+  void DataFormats::fillFields() {
+    for (const Process p : Processes) {
+      vector<Field>& fields = fields_[+p];
+      fields.reserve(stubs_[+p].size());
+      int offset(0);
+      for (auto v = rbegin(stubs_[+p]); v != rend(stubs_[+p]); v++) {
+        const DataFormat* format = formats_[+*v][+p];
+        fields.emplace_back(format, offset);
+        offset += fields.back().width();
+      }
+      reverse(fields.begin(), fields.end());
+    }
+  }
+
+  // track parameter and hit layer pattern plus stub position have to fit into one frame each
+  void DataFormats::checkTracks() const {
+    const int widthStubs = setup_->numLayers() + 2 * widthStubs_;
+    for (const Process p : Processes) {
+      if (tracks_[+p].size() == 0)
+        continue;
+      int widthParameter(0);
+      for (const Variable v : tracks_[+p])
+        widthParameter += width(v, p);
+      if (widthParameter > TTBV::S || widthStubs > TTBV::S) {
+        cms::Exception exception("BadConfiguration");
+        exception << "Tracks of process " << +p << " need " << widthParameter << " bits for track parameter and "
+                  << widthStubs << " bits for hit pattern and stub position but a frame holds " << TTBV::S << " bits.";
+        exception.addContext("trackerTFP::DataFormats::checkTracks");
+        throw exception;
+      }
+    }
+  }
+
+  // all bases involved in phi residuals are power of two multiples of each other, the cot dependent z residuals are
+  // tabulated per eta sector and r
+  void DataFormats::fillIntegerDomain() {
+    const double basePhi = base(Variable::phi, Process::gp);
+    const double basePhiT = base(Variable::phiT, Process::lf);
+    const double baseR = base(Variable::r, Process::lf);
+    const double baseZ = base(Variable::z, Process::gp);
+    const int shiftSector = exponent(setup_->baseSector() / basePhi, "sector phi");
+    const int shiftPhi = exponent(basePhi / basePhiT, "stub phi");
+    const int shiftR = exponent(base(Variable::qOverPt, Process::lf) * baseR / basePhiT, "qOverPt * r");
+    // gp phi = floor(phi + .5 - (sectorPhi - .5) * baseSector / basePhi)
+    const int gpShiftPhi = max(0, -shiftSector);
+    const int gpShiftSector = shiftSector + gpShiftPhi;
+    gpShift_ = gpShiftPhi + 1;
+    offsetsPhi_.reserve(setup_->numSectorsPhi());
+    for (int sectorPhi = 0; sectorPhi < setup_->numSectorsPhi(); sectorPhi++)
+      offsetsPhi_.push_back((2LL * sectorPhi - 1) * (1LL << gpShiftSector) - (1LL << gpShiftPhi));
+    // gp z = z + floor(.5 - (r + chosenRofPhi) * cot / baseZ)
+    const int widthR = width(Variable::r, Process::lf);
+    offsetR_ = 1 << (widthR - 1);
+    widthOffsetsZ_ = 1 << widthR;
+    offsetsZ_.reserve(setup_->numSectorsEta() * widthOffsetsZ_);
+    for (int sectorEta = 0; sectorEta < setup_->numSectorsEta(); sectorEta++) {
+      const double cot = setup_->sectorCot(sectorEta);
+      for (int r = -offsetR_; r < offsetR_; r++)
+        offsetsZ_.push_back(floor(.5 - ((r + .5) * baseR + setup_->chosenRofPhi()) * cot / baseZ));
+    }
+    // lf phi = floor(phi + .5 + (qOverPt + .5) * (r + .5) * 2^(shiftR - shiftPhi) - (phiT + .5) * 2^-shiftPhi)
+    lfShift_ = max({1, shiftPhi + 1, shiftPhi - shiftR + 2});
+    lfShiftPhi_ = lfShift_ - 1;
+    lfShiftR_ = shiftR - shiftPhi - 2 + lfShift_;
+    lfShiftPhiT_ = lfShift_ - shiftPhi - 1;
+    // ht phiT = (phi + .5) * 2^shiftPhi + (qOverPt + .5) * (r + .5) * 2^shiftR
+    htShift_ = max({0, 1 - shiftPhi, 2 - shiftR});
+    htShiftPhi_ = shiftPhi - 1 + htShift_;
+    htShiftR_ = shiftR - 2 + htShift_;
+    // mht phiT = (phi + .5) * 2^shiftPhi * nPhiT + nPhiT / 2
+    //          + (qOverPt + .5 - nQoverPt / 2) * (r + .5) * 2^shiftR * nPhiT / nQoverPt, fine bins w.r.t. lf cell
+    const int widthBinsPhiT = exponent(setup_->mhtNumBinsPhiT(), "mht phiT bins");
+    const int widthBinsQoverPt = exponent(setup_->mhtNumBinsQoverPt(), "mht qOverPt bins");
+    mhtShift_ = max({1, 1 - widthBinsPhiT - shiftPhi, 2 + widthBinsQoverPt - widthBinsPhiT - shiftR});
+    mhtShiftPhi_ = widthBinsPhiT + shiftPhi - 1 + mhtShift_;
+    mhtShiftR_ = widthBinsPhiT + shiftR - 2 - widthBinsQoverPt + mhtShift_;
+    mhtShiftOffset_ = widthBinsPhiT - 1 + mhtShift_;
+    mhtShiftResid_ = mhtShift_ + widthBinsPhiT + shiftPhi;
+  }
+
+  int DataFormats::exponent(double ratio, const string& name) {
+    const int n = lround(log2(ratio));
+    if (abs(ratio / pow(2., n) - 1.) > 1.e-9) {
+      cms::Exception exception("BadConfiguration");
+      exception << "Ratio of bases used for " << name << " is " << ratio << " but has to be a power of two.";
+      exception.addContext("trackerTFP::DataFormats::exponent");
+      throw exception;
+    }
+    return n;
+  }
+
+  // loop over contiguous values of any sectors, sector offsets are gathered per value
+  void DataFormats::phiGP(int* phi, const int* sectorPhi, int n) const {
+    const long long factor = 1LL << gpShift_;
+    const long long* offsets = offsetsPhi_.data();
+#pragma GCC ivdep
+    for (int i = 0; i < n; i++)
+      phi[i] = floorShift(phi[i] * factor - offsets[sectorPhi[i]], gpShift_);
+  }
+
+  // look up of sector z residuals for contiguous values of any sectors
+  void DataFormats::zGP(int* z, const int* r, const int* sectorEta, int n) const {
+    const int* offsets = offsetsZ_.data() + offsetR_;
+#pragma GCC ivdep
+    for (int i = 0; i < n; i++)
+      z[i] += offsets[sectorEta[i] * widthOffsetsZ_ + r[i]];
+  }
+
+  int DataFormats::phiLF(int phi, int r, int qOverPt, int phiT) const {
+    const long long n = (2LL * phi + 1) * (1LL << lfShiftPhi_) +
+                        (2LL * qOverPt + 1) * (2LL * r + 1) * (1LL << lfShiftR_) -
+                        (2LL * phiT + 1) * (1LL << lfShiftPhiT_);
+    return floorShift(n, lfShift_);
+  }
+
+  bool DataFormats::phiT(int phi, int r, int qOverPt, int& major, int& minor) const {
+    const long long n =
+        (2LL * phi + 1) * (1LL << htShiftPhi_) + (2LL * qOverPt + 1) * (2LL * r + 1) * (1LL << htShiftR_);
+    major = floorShift(n, htShift_);
+    // twice the distance to the centre of the major bin
+    const long long chi = 2 * n - (2LL * major + 1) * (1LL << htShift_);
+    minor = chi >= 0 ? major + 1 : major - 1;
+    return abs(2LL * r + 1) * (1LL << (htShiftR_ + 1)) + abs(chi) >= (1LL << htShift_);
+  }
+
+  // branch free loop over contiguous values of one qOverPt bin
+  void DataFormats::phiT(const int* phi, const int* r, int n, int qOverPt, int* major, int* minor) const {
+    const long long factorPhi = 1LL << htShiftPhi_;
+    const long long factorR = (2LL * qOverPt + 1) * (1LL << htShiftR_);
+    const long long factorSlope = 1LL << (htShiftR_ + 1);
+    const long long widthBin = 1LL << htShift_;
+    for (int i = 0; i < n; i++) {
+      const long long sum = (2LL * phi[i] + 1) * factorPhi + (2LL * r[i] + 1) * factorR;
+      const int bin = floorShift(sum, htShift_);
+      const long long chi = 2 * sum - (2LL * bin + 1) * widthBin;
+      const bool twoCandidates = abs(2LL * r[i] + 1) * factorSlope + abs(chi) >= widthBin;
+      major[i] = bin;
+      minor[i] = twoCandidates ? (chi >= 0 ? bin + 1 : bin - 1) : bin;
+    }
+  }
+
+  int DataFormats::phiTMHT(int& phi, int r, int binQoverPt) const {
+    const long long n = (2LL * phi + 1) * (1LL << mhtShiftPhi_) +
+                        (2LL * binQoverPt + 1 - setup_->mhtNumBinsQoverPt()) * (2LL * r + 1) * (1LL << mhtShiftR_) +
+                        (1LL << mhtShiftOffset_);
+    const int bin = floorShift(n, mhtShift_);
+    // distance to fine cell centre
+    const long long chi = n - (2LL * bin + 1) * (1LL << (mhtShift_ - 1));
+    phi = floorShift(chi, mhtShiftResid_);
+    return bin;
+  }
+
   template<typename ...Ts>
   void DataFormats::convert(const TTDTC::BV& bv, tuple<Ts...>& data, Process p) const {
-    TTBV ttBV(bv);
-    extract(ttBV, data, p);
+    extract(bv.to_ullong(), data, fields_[+p]);
   }
 
   template<int it = 0, typename ...Ts>
-  void DataFormats::extract(TTBV& ttBV, std::tuple<Ts...>& data, Process p) const {
-    Variable v = *next(stubs_[+p].begin(), sizeof...(Ts) - 1 - it);
-    formats_[+v][+p]->extract(ttBV, get<sizeof...(Ts) - 1 - it>(data));
+  void DataFormats::extract(unsigned long long word, std::tuple<Ts...>& data, const vector<Field>& fields) const {
+    fields[it].extract(word, get<it>(data));
     if constexpr(it + 1 != sizeof...(Ts))
-      extract<it + 1>(ttBV, data, p);
+      extract<it + 1>(word, data, fields);
   }
 
   template<typename... Ts>
   void DataFormats::convert(const std::tuple<Ts...>& data, TTDTC::BV& bv, Process p) const {
-    TTBV ttBV;
-    attach(data, ttBV, p);
-    bv = ttBV.bs();
+    unsigned long long word(0);
+    attach(data, word, fields_[+p]);
+    bv = TTDTC::BV(word);
   }
 
   template<int it = 0, typename... Ts>
-  void DataFormats::attach(const tuple<Ts...>& data, TTBV& ttBV, Process p) const {
-    Variable v = *next(stubs_[+p].begin(), it);
-    formats_[+v][+p]->attach(get<it>(data), ttBV);
+  void DataFormats::attach(const tuple<Ts...>& data, unsigned long long& word, const vector<Field>& fields) const {
+    fields[it].attach(get<it>(data), word);
     if constexpr(it + 1 != sizeof...(Ts))
-      attach<it + 1>(data, ttBV, p);
+      attach<it + 1>(data, word, fields);
+  }
+
+  Field::Field(const DataFormat* format, int offset) :
+    offset_(offset),
+    width_(format ? format->width() : 0),
+    twos_(format ? format->twos() : false),
+    base_(format ? format->base() : 1.),
+    mask_(width_ < TTBV::S ? (1ULL << width_) - 1 : ~0ULL)
+  {}
+
+  int Field::integer(unsigned long long word) const {
+    const unsigned long long value = bits(word);
+    if (twos_ && width_ > 0 && (value >> (width_ - 1)) & 1)
+      return value - (1ULL << width_);
+    return value;
   }
 
   template<typename ...Ts>
@@ -111,11 +297,15 @@ namespace trackerTFP {
   Stub<Ts...>::Stub(const Stub<Others...>& stub, Ts... data) :
     dataFormats_(stub.dataFormats()),
     p_(++stub.p()),
-    frame_(stub.frame().first, TTDTC::BV()),
+    frame_(stub.ttStubRef(), TTDTC::BV()),
     data_(data...),
     trackId_(0)
-  {
-    //dataFormats_->convert(data_, frame_.second, p_);
+  {}
+
+  template<typename ...Ts>
+  void Stub<Ts...>::encode() {
+    // data of derived stubs is digitised, so converting is exact
+    dataFormats_->convert(data_, frame_.second, p_);
   }
 
   StubPP::StubPP(const TTDTC::Frame& frame, const DataFormats* formats) :
@@ -140,10 +330,13 @@ namespace trackerTFP {
     sectorPhi_(sectorPhi),
     sectorEta_(sectorEta)
   {
-    const Setup* setup = dataFormats_->setup();
-    get<1>(data_) -= (sectorPhi_ - .5) * setup->baseSector();
-    get<2>(data_) -= (r() + setup->chosenRofPhi()) * setup->sectorCot(sectorEta_);
-    dataFormats_->convert(data_, frame_.second, p_);
+    // sector residuals are calculated on digitised values
+    const int r = stub.integer(0);
+    const int phi = dataFormats_->phiGP(stub.integer(1), sectorPhi_);
+    const int z = dataFormats_->zGP(stub.integer(2), r, sectorEta_);
+    get<1>(data_) = format(Variable::phi).floating(phi);
+    get<2>(data_) = format(Variable::z).floating(z);
+    encode();
   }
 
   StubLF::StubLF(const TTDTC::Frame& frame, const DataFormats* formats, int qOverPt) :
@@ -156,16 +349,90 @@ namespace trackerTFP {
     Stub(stub, stub.r(), stub.phi(), stub.z(), stub.layer(), stub.sectorPhi(), stub.sectorEta(), phiT),
     qOverPt_(qOverPt)
   {
-    get<1>(data_) += format(Variable::qOverPt).floating(this->qOverPt()) * r() - format(Variable::phiT).floating(this->phiT());
+    // track residual is calculated on digitised values
+    const int r = dataFormats_->format(Variable::r, stub.p()).integer(stub.r());
+    const int phi = dataFormats_->format(Variable::phi, stub.p()).integer(stub.phi());
+    get<1>(data_) = format(Variable::phi).floating(dataFormats_->phiLF(phi, r, this->qOverPt(), this->phiT()));
     fillTrackId();
-    dataFormats_->convert(data_, frame_.second, p_);
+    encode();
   }
 
   void StubLF::fillTrackId() {
-    TTBV ttBV(bv());
-    trackId_ = ttBV.extract(width(Variable::sectorPhi) + width(Variable::sectorEta) + width(Variable::phiT));
+    // sectorPhi, sectorEta and phiT occupy the least significant bits of a LF frame
+    const vector<Field>& fields = dataFormats_->fields(p_);
+    unsigned long long word(0);
+    fields[4].attach(sectorPhi(), word);
+    fields[5].attach(sectorEta(), word);
+    fields[6].attach(phiT(), word);
+    trackId_ = word;
+  }
+
+  StubLR::StubLR(const TTDTC::Frame& frame, const DataFormats* formats) :
+    Stub(frame, formats, Process::lr)
+  {}
+
+  template<typename ...Ts>
+  Track<Ts...>::Track(TTDTC::Stream::const_iterator frame, const DataFormats* dataFormats, Process p) :
+    dataFormats_(dataFormats),
+    p_(p)
+  {
+    copy(frame, next(frame, DataFormats::numFramesTrack_), frames_.begin());
+    // track parameter are read msb first
+    const TTBV ttBV(frames_[0].second);
+    int pos(0);
+    for (Variable v : dataFormats_->tracks(p_))
+      pos += dataFormats_->width(v, p_);
+    auto variable = dataFormats_->tracks(p_).begin();
+    auto extract = [this, &ttBV, &pos, &variable](int& value) {
+      const DataFormat& format = dataFormats_->format(*variable++, p_);
+      value = ttBV.val(pos, pos - format.width(), format.twos());
+      pos -= format.width();
+    };
+    apply([&extract](auto&... values){ (extract(values), ...); }, data_);
+    // hit pattern followed by stub position
+    const TTBV stubs(frames_[1].second);
+    const int widthStubs = DataFormats::widthStubs_;
+    hitPattern_ = stubs.val(2 * widthStubs + dataFormats_->setup()->numLayers(), 2 * widthStubs);
+    begin_ = stubs.val(2 * widthStubs, widthStubs);
+    size_ = stubs.val(widthStubs);
+  }
+
+  template<typename ...Ts>
+  Track<Ts...>::Track(const TTStubRef& ttStubRef, const DataFormats* dataFormats, Process p, const tuple<Ts...>& data,
+                      int hitPattern, int begin, int size) :
+    dataFormats_(dataFormats),
+    p_(p),
+    data_(data),
+    hitPattern_(hitPattern),
+    begin_(begin),
+    size_(size)
+  {
+    const int widthStubs = DataFormats::widthStubs_;
+    if (end() > 1 << widthStubs) {
+      cms::Exception exception("out_of_range");
+      exception << "Track stubs end at position " << end() << " but at most " << (1 << widthStubs)
+                << " stub positions are addressable.";
+      exception.addContext("trackerTFP::Track::Track");
+      throw exception;
+    }
+    TTBV ttBV;
+    auto variable = dataFormats_->tracks(p_).begin();
+    auto attach = [this, &ttBV, &variable](int value){ dataFormats_->format(*variable++, p_).attach(value, ttBV); };
+    apply([&attach](auto... values){ (attach(values), ...); }, data_);
+    frames_[0] = TTDTC::Frame(ttStubRef, ttBV.bs());
+    TTBV stubs(hitPattern_, dataFormats_->setup()->numLayers());
+    stubs += TTBV(begin_, widthStubs);
+    stubs += TTBV(size_, widthStubs);
+    frames_[1] = TTDTC::Frame(ttStubRef, stubs.bs());
   }
 
+  template class Stub<double, double, double, int, TTBV, int, int, int, int>;
+  template class Stub<double, double, double, int, int, int>;
+  template class Stub<double, double, double, int, int, int, int>;
+  template class Stub<double, double, double, int>;
+  template class Track<int, int, int, int>;
+  template class Track<int, int, int, int, int, int>;
+
   template<>
   Format<Variable::phiT, Process::lf>::Format(const Setup* setup) : DataFormat(true) {
     range_ = 2. * M_PI / (double)(setup->numRegions() * setup->numSectorsPhi());
@@ -180,6 +447,100 @@ namespace trackerTFP {
     width_ = ceil(log2(setup->htNumBinsQoverPt()));
   }
 
+  template<>
+  Format<Variable::phiT, Process::lr>::Format(const Setup* setup) : DataFormat(true) {
+    const Format<Variable::phiT, Process::lf> lf(setup);
+    range_ = lf.range();
+    base_ = lf.base() * pow(2., setup->lrBaseDiffPhiT());
+    width_ = ceil(log2(range_ / base_));
+  }
+
+  template<>
+  Format<Variable::qOverPt, Process::lr>::Format(const Setup* setup) : DataFormat(true) {
+    const Format<Variable::qOverPt, Process::lf> lf(setup);
+    range_ = lf.range();
+    base_ = lf.base() * pow(2., setup->lrBaseDiffQoverPt());
+    width_ = ceil(log2(range_ / base_));
+  }
+
+  template<>
+  Format<Variable::zT, Process::lr>::Format(const Setup* setup) : DataFormat(true) {
+    range_ = 2. * setup->maxZT();
+    const Format<Variable::z, Process::gp> z(setup);
+    base_ = z.base() * pow(2., setup->lrBaseDiffZT());
+    width_ = ceil(log2(range_ / base_));
+  }
+
+  template<>
+  Format<Variable::cot, Process::lr>::Format(const Setup* setup) : DataFormat(true) {
+    range_ = 2. * setup->maxCot();
+    // natural unit of a z over r slope
+    const Format<Variable::z, Process::gp> z(setup);
+    const Format<Variable::r, Process::lf> r(setup);
+    base_ = z.base() / r.base() * pow(2., setup->lrBaseDiffCot());
+    width_ = ceil(log2(range_ / base_));
+  }
+
+  template<>
+  Format<Variable::phiT, Process::mht>::Format(const Setup* setup) : DataFormat(true) {
+    const Format<Variable::phiT, Process::lf> lf(setup);
+    range_ = lf.range();
+    base_ = setup->mhtBasePhiT();
+    width_ = setup->mhtWidthPhiT();
+  }
+
+  template<>
+  Format<Variable::qOverPt, Process::mht>::Format(const Setup* setup) : DataFormat(true) {
+    const Format<Variable::qOverPt, Process::lf> lf(setup);
+    range_ = lf.range();
+    base_ = setup->mhtBaseQoverPt();
+    width_ = setup->mhtWidthQoverPt();
+  }
+
+  template<>
+  Format<Variable::zT, Process::sf>::Format(const Setup* setup) : DataFormat(true) {
+    range_ = 2. * setup->maxZT();
+    base_ = setup->sfBaseZT();
+    width_ = ceil(log2(range_ / base_));
+  }
+
+  template<>
+  Format<Variable::cot, Process::sf>::Format(const Setup* setup) : DataFormat(true) {
+    range_ = 2. * setup->maxCot();
+    base_ = setup->sfBaseCot();
+    width_ = ceil(log2(range_ / base_));
+  }
+
+  template<>
+  Format<Variable::phiT, Process::kf>::Format(const Setup* setup) : DataFormat(true) {
+    const Format<Variable::phiT, Process::lf> lf(setup);
+    range_ = lf.range();
+    base_ = setup->kfBasex1();
+    width_ = ceil(log2(range_ / base_));
+  }
+
+  template<>
+  Format<Variable::qOverPt, Process::kf>::Format(const Setup* setup) : DataFormat(true) {
+    const Format<Variable::qOverPt, Process::lf> lf(setup);
+    range_ = lf.range();
+    base_ = setup->kfBasex0();
+    width_ = ceil(log2(range_ / base_));
+  }
+
+  template<>
+  Format<Variable::zT, Process::kf>::Format(const Setup* setup) : DataFormat(true) {
+    range_ = 2. * setup->maxZT();
+    base_ = setup->kfBasex3();
+    width_ = ceil(log2(range_ / base_));
+  }
+
+  template<>
+  Format<Variable::cot, Process::kf>::Format(const Setup* setup) : DataFormat(true) {
+    range_ = 2. * setup->maxCot();
+    base_ = setup->kfBasex2();
+    width_ = ceil(log2(range_ / base_));
+  }
+
   template<>
   Format<Variable::r, Process::lf>::Format(const Setup* setup) : DataFormat(true) {
     width_ = setup->widthR();
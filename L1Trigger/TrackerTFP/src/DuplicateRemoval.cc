@@ -0,0 +1,154 @@
+#include "L1Trigger/TrackerTFP/interface/DuplicateRemoval.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+using namespace edm;
+using namespace trackerDTC;
+
+namespace trackerTFP {
+
+  DuplicateRemoval::DuplicateRemoval(const ParameterSet& iConfig,
+                                     const Setup* setup,
+                                     const DataFormats* dataFormats,
+                                     int region) :
+    setup_(setup),
+    dataFormats_(dataFormats),
+    region_(region),
+    depth_(setup_->drDepthMemory()),
+    head_(0),
+    size_(0)
+  {
+    if (depth_ < 1) {
+      cms::Exception exception("BadConfiguration");
+      exception << "DR memory depth is " << depth_ << " but at least 1 is required.";
+      exception.addContext("trackerTFP::DuplicateRemoval::DuplicateRemoval");
+      throw exception;
+    }
+    // tracks are duplicates if their helix parameter fall into the same candidate cell
+    auto shift = [this](Variable v, Process p, const string& name){
+      return DataFormats::exponent(dataFormats_->base(v, p) / dataFormats_->base(v, Process::kf), name);
+    };
+    shiftQoverPt_ = shift(Variable::qOverPt, Process::mht, "dr qOverPt");
+    shiftPhiT_ = shift(Variable::phiT, Process::mht, "dr phiT");
+    shiftCot_ = shift(Variable::cot, Process::sf, "dr cot");
+    shiftZT_ = shift(Variable::zT, Process::sf, "dr zT");
+    // phi sectors are phiT range wide and their centres are phiT range apart
+    const DataFormat& phiT = dataFormats_->format(Variable::phiT, Process::mht);
+    binsPerSector_ = 1 << DataFormats::exponent(phiT.range() / phiT.base(), "dr phiT bins per sector");
+    // hash table is kept at most half full
+    widthTable_ = ceil(log2(2 * depth_));
+    table_.assign(1 << widthTable_, 0);
+    memory_.assign(depth_, 0);
+  }
+
+  // drop tracks of previous event, allocated memory is kept
+  void DuplicateRemoval::clear() {
+    for (vector<int>* v : {&channel_, &end_, &sectorPhi_, &sectorEta_, &qOverPt_, &phiT_, &cot_, &zT_, &hitPattern_,
+                           &begin_, &order_})
+      v->clear();
+    frames_.clear();
+    fill(table_.begin(), table_.end(), 0);
+    head_ = 0;
+    size_ = 0;
+  }
+
+  // read in and organize input product
+  void DuplicateRemoval::consume(const TTDTC::Streams& stubs, const TTDTC::Streams& tracks) {
+    clear();
+    const int numChannel = dataFormats_->numChannel(Process::kf);
+    const int offset = region_ * numChannel;
+    for (int channel = 0; channel < numChannel; channel++) {
+      const TTDTC::Stream& stream = stubs[offset + channel];
+      const TTDTC::Stream& streamTracks = tracks[offset + channel];
+      for (auto frame = streamTracks.begin(); frame != streamTracks.end(); frame += DataFormats::numFramesTrack_) {
+        if (frame->first.isNull())
+          continue;
+        const TrackKF track(frame, dataFormats_);
+        channel_.push_back(channel);
+        end_.push_back(track.end());
+        sectorPhi_.push_back(track.sectorPhi());
+        sectorEta_.push_back(track.sectorEta());
+        qOverPt_.push_back(track.qOverPt());
+        phiT_.push_back(track.phiT());
+        cot_.push_back(track.cot());
+        zT_.push_back(track.zT());
+        hitPattern_.push_back(track.hitPattern());
+        begin_.push_back(frames_.size());
+        frames_.insert(frames_.end(), next(stream.begin(), track.begin()), next(stream.begin(), track.end()));
+      }
+    }
+    begin_.push_back(frames_.size());
+    // tracks of all channels are compared in the order they are received
+    order_.resize(channel_.size());
+    iota(order_.begin(), order_.end(), 0);
+    stable_sort(order_.begin(), order_.end(), [this](int lhs, int rhs){ return end_[lhs] < end_[rhs]; });
+  }
+
+  // fill output products
+  void DuplicateRemoval::produce(TTDTC::Streams& accepted, TTDTC::Streams& tracks) {
+    const int offset = region_ * dataFormats_->numChannel(Process::dr);
+    for (int track : order_) {
+      const unsigned long long k = key(track);
+      if (table_[find(k)] == k)
+        continue;
+      insert(k);
+      TTDTC::Stream& stream = accepted[offset + channel_[track]];
+      const int begin = stream.size();
+      stream.insert(stream.end(), next(frames_.begin(), begin_[track]), next(frames_.begin(), begin_[track + 1]));
+      const TrackDR trackDR(stream[begin].first, dataFormats_, sectorPhi_[track], sectorEta_[track], qOverPt_[track],
+                            phiT_[track], cot_[track], zT_[track], hitPattern_[track], begin, stream.size() - begin);
+      trackDR.put(tracks[offset + channel_[track]]);
+    }
+  }
+
+  // helix parameter of given track digitised into the cell size used to form candidates, never 0
+  unsigned long long DuplicateRemoval::key(int track) const {
+    // floor(value * 2^-shift) for both signs, truncated to 15 bits
+    auto field = [](int value, int shift){ return (unsigned long long)((value >> shift) & 0x7fff); };
+    // phiT cell w.r.t. the region, so that duplicates found in both overlapping phi sectors share a key
+    const int phiT = (phiT_[track] >> shiftPhiT_) + sectorPhi_[track] * binsPerSector_;
+    return 1ULL << 63 | field(qOverPt_[track], shiftQoverPt_) << 45 | field(phiT, 0) << 30 |
+           field(cot_[track], shiftCot_) << 15 | field(zT_[track], shiftZT_);
+  }
+
+  // table slot holding given key or the empty slot where it would be stored
+  int DuplicateRemoval::find(unsigned long long key) const {
+    const int mask = table_.size() - 1;
+    int slot = (key * 0x9e3779b97f4a7c15ULL) >> (64 - widthTable_);
+    while (table_[slot] != 0 && table_[slot] != key)
+      slot = (slot + 1) & mask;
+    return slot;
+  }
+
+  // stores given key, the oldest key is forgotten if the memory is full
+  void DuplicateRemoval::insert(unsigned long long key) {
+    if (size_ == depth_) {
+      erase(find(memory_[head_]));
+      head_ = (head_ + 1) % depth_;
+      size_--;
+    }
+    table_[find(key)] = key;
+    memory_[(head_ + size_++) % depth_] = key;
+  }
+
+  // removes key stored in given slot, keeps linear probing sequences intact
+  void DuplicateRemoval::erase(int slot) {
+    const int mask = table_.size() - 1;
+    int gap = slot;
+    for (int i = (gap + 1) & mask; table_[i] != 0; i = (i + 1) & mask) {
+      const int home = (table_[i] * 0x9e3779b97f4a7c15ULL) >> (64 - widthTable_);
+      // key may move into the gap if the gap lies between its home slot and its current slot
+      if (((i - home) & mask) >= ((i - gap) & mask)) {
+        table_[gap] = table_[i];
+        gap = i;
+      }
+    }
+    table_[gap] = 0;
+  }
+
+} // namespace trackerTFP
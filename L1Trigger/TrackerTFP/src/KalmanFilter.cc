@@ -0,0 +1,384 @@
+#include "L1Trigger/TrackerTFP/interface/KalmanFilter.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <vector>
+#include <string>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+using namespace edm;
+using namespace trackerDTC;
+
+namespace trackerTFP {
+
+  KalmanFilter::KalmanFilter(const ParameterSet& iConfig,
+                             const Setup* setup,
+                             const DataFormats* dataFormats,
+                             int region) :
+    setup_(setup),
+    dataFormats_(dataFormats),
+    region_(region),
+    numLayers_(setup_->numLayers()),
+    maxStubsPerLayer_(setup_->kfMaxStubsPerLayer()),
+    maxLayers_(setup_->kfMaxLayers())
+  {
+    // hit layer patterns are 32 bit masks
+    if (numLayers_ > 32) {
+      cms::Exception exception("BadConfiguration");
+      exception << "Number of layers is " << numLayers_ << " but at most 32 are supported.";
+      exception.addContext("trackerTFP::KalmanFilter::KalmanFilter");
+      throw exception;
+    }
+    const double baseR = dataFormats_->base(Variable::r, Process::sf);
+    const double basePhi = dataFormats_->base(Variable::phi, Process::sf);
+    const double baseZ = dataFormats_->base(Variable::z, Process::sf);
+    const double baseQoverPt = dataFormats_->base(Variable::qOverPt, Process::sf);
+    const double basePhiT = dataFormats_->base(Variable::phiT, Process::sf);
+    const double baseCot = dataFormats_->base(Variable::cot, Process::sf);
+    const double baseZT = dataFormats_->base(Variable::zT, Process::sf);
+    // exponent n to convert a value given in base from into base to by value * 2^-n
+    auto shift = [](double from, double to, const string& name){ return DataFormats::exponent(to / from, name); };
+    const Setup* s = setup_;
+    // H00 = -r and H12 = r - (chosenRofZ - chosenRofPhi) are given in r base
+    shiftS00_ = shift(baseR * s->kfBaseC00(), s->kfBaseS00(), "H00 * C00");
+    shiftS00C01_ = shift(s->kfBaseC01(), s->kfBaseS00(), "C01");
+    shiftS01_ = shift(baseR * s->kfBaseC01(), s->kfBaseS01(), "H00 * C01");
+    shiftS01C11_ = shift(s->kfBaseC11(), s->kfBaseS01(), "C11");
+    shiftS12_ = shift(baseR * s->kfBaseC22(), s->kfBaseS12(), "H12 * C22");
+    shiftS12C23_ = shift(s->kfBaseC23(), s->kfBaseS12(), "C23");
+    shiftS13_ = shift(baseR * s->kfBaseC23(), s->kfBaseS13(), "H12 * C23");
+    shiftS13C33_ = shift(s->kfBaseC33(), s->kfBaseS13(), "C33");
+    shiftR00_ = shift(baseR * s->kfBaseS00(), s->kfBaseR00(), "H00 * S00");
+    shiftR00v0_ = shift(s->kfBasev0(), s->kfBaseR00(), "v0");
+    shiftR00S01_ = shift(s->kfBaseS01(), s->kfBaseR00(), "S01");
+    shiftR11_ = shift(baseR * s->kfBaseS12(), s->kfBaseR11(), "H12 * S12");
+    shiftR11v1_ = shift(s->kfBasev1(), s->kfBaseR11(), "v1");
+    shiftR11S13_ = shift(s->kfBaseS13(), s->kfBaseR11(), "S13");
+    shiftK00_ = shift(s->kfBaseS00() * s->kfBaseInvR00(), s->kfBaseK00(), "S00 * invR00");
+    shiftK10_ = shift(s->kfBaseS01() * s->kfBaseInvR00(), s->kfBaseK10(), "S01 * invR00");
+    shiftK21_ = shift(s->kfBaseS12() * s->kfBaseInvR11(), s->kfBaseK21(), "S12 * invR11");
+    shiftK31_ = shift(s->kfBaseS13() * s->kfBaseInvR11(), s->kfBaseK31(), "S13 * invR11");
+    shiftr0_ = shift(baseR * s->kfBasex0(), s->kfBaser0(), "H00 * x0");
+    shiftr0m0_ = shift(basePhi, s->kfBaser0(), "m0");
+    shiftr0x1_ = shift(s->kfBasex1(), s->kfBaser0(), "x1");
+    shiftr1_ = shift(baseR * s->kfBasex2(), s->kfBaser1(), "H12 * x2");
+    shiftr1m1_ = shift(baseZ, s->kfBaser1(), "m1");
+    shiftr1x3_ = shift(s->kfBasex3(), s->kfBaser1(), "x3");
+    shiftx0_ = shift(s->kfBaseK00() * s->kfBaser0(), s->kfBasex0(), "K00 * r0");
+    shiftx1_ = shift(s->kfBaseK10() * s->kfBaser0(), s->kfBasex1(), "K10 * r0");
+    shiftx2_ = shift(s->kfBaseK21() * s->kfBaser1(), s->kfBasex2(), "K21 * r1");
+    shiftx3_ = shift(s->kfBaseK31() * s->kfBaser1(), s->kfBasex3(), "K31 * r1");
+    shiftC00_ = shift(s->kfBaseK00() * s->kfBaseS00(), s->kfBaseC00(), "K00 * S00");
+    shiftC01_ = shift(s->kfBaseK00() * s->kfBaseS01(), s->kfBaseC01(), "K00 * S01");
+    shiftC11_ = shift(s->kfBaseK10() * s->kfBaseS01(), s->kfBaseC11(), "K10 * S01");
+    shiftC22_ = shift(s->kfBaseK21() * s->kfBaseS12(), s->kfBaseC22(), "K21 * S12");
+    shiftC23_ = shift(s->kfBaseK21() * s->kfBaseS13(), s->kfBaseC23(), "K21 * S13");
+    shiftC33_ = shift(s->kfBaseK31() * s->kfBaseS13(), s->kfBaseC33(), "K31 * S13");
+    shiftr02_ = shift(s->kfBaser0() * s->kfBaser0(), s->kfBaser02(), "r0 * r0");
+    shiftr12_ = shift(s->kfBaser1() * s->kfBaser1(), s->kfBaser12(), "r1 * r1");
+    shiftChi20_ = shift(s->kfBaser02() * s->kfBaseInvR00(), s->kfBaseChi20(), "r02 * invR00");
+    shiftChi21_ = shift(s->kfBaser12() * s->kfBaseInvR11(), s->kfBaseChi21(), "r12 * invR11");
+    shiftChi2r0_ = shift(s->kfBaseChi20(), s->kfBaseChi2(), "chi20");
+    shiftChi2r1_ = shift(s->kfBaseChi21(), s->kfBaseChi2(), "chi21");
+    // invR = 2^shiftInvR / R
+    shiftInvR00_ = DataFormats::exponent(1. / s->kfBaseR00() / s->kfBaseInvR00(), "R00 * invR00");
+    shiftInvR11_ = DataFormats::exponent(1. / s->kfBaseR11() / s->kfBaseInvR11(), "R11 * invR11");
+    for (pair<vector<long long>*, int> lut : {make_pair(&lutInvPhi_, s->kfWidthLutInvPhi()),
+                                              make_pair(&lutInvZ_, s->kfWidthLutInvZ())}) {
+      const int width = lut.second;
+      lut.first->reserve(1 << width);
+      for (int m = 0; m < (1 << width); m++)
+        lut.first->push_back(floor(pow(2., 2 * width) / (m + .5)));
+    }
+    // seed and track cells are given in half lsbs
+    shiftZT_ = shift(baseZT / 2., baseZ, "seed zT");
+    shiftCot_ = shift(baseCot * baseR / 4., baseZ, "seed cot * r");
+    shiftQoverPtKF_ = shift(baseQoverPt / 2., s->kfBasex0(), "kf qOverPt");
+    shiftPhiTKF_ = shift(basePhiT / 2., s->kfBasex1(), "kf phiT");
+    shiftCotKF_ = shift(baseCot / 2., s->kfBasex2(), "kf cot");
+    shiftZTKF_ = shift(baseZT / 2., s->kfBasex3(), "kf zT");
+    leverR_ = lround((s->chosenRofZ() - s->chosenRofPhi()) / baseR);
+    leverZT_ = lround((s->chosenRofZ() - s->chosenRofPhi()) / baseR * 2.);
+    offsetsCot_.reserve(s->numSectorsEta());
+    offsetsZT_.reserve(s->numSectorsEta());
+    for (int sectorEta = 0; sectorEta < s->numSectorsEta(); sectorEta++) {
+      const double cot = s->sectorCot(sectorEta);
+      offsetsCot_.push_back(floor(cot / baseCot + .5));
+      offsetsZT_.push_back(floor(cot * s->chosenRofZ() / baseZT + .5));
+    }
+    // initial uncertainties are given by the cell sizes of the input track
+    initC00_ = lround(baseQoverPt * baseQoverPt / s->kfBaseC00());
+    initC11_ = lround(basePhiT * basePhiT / s->kfBaseC11());
+    initC22_ = lround(baseCot * baseCot / s->kfBaseC22());
+    initC33_ = lround(baseZT * baseZT / s->kfBaseC33());
+    // no stub resolutions are configured, variances of uniform distributions within the linear regression windows
+    v0_ = max(1L, lround(pow(s->lrResidPhi(), 2) / 3. / s->kfBasev0()));
+    v1PS_ = max(1L, lround(pow(s->lrResidZPS(), 2) / 3. / s->kfBasev1()));
+    v12S_ = max(1L, lround(pow(s->lrResidZ2S(), 2) / 3. / s->kfBasev1()));
+  }
+
+  // drop tracks of previous event, allocated memory is kept
+  void KalmanFilter::clear() {
+    for (vector<int>* v : {&channel_, &sectorPhi_, &sectorEta_, &qOverPt_, &phiT_, &cot_, &zT_, &layerSize_,
+                           &layerStubs_, &m0_, &m1_, &H00_, &H12_, &layer_, &track_, &stub_, &numStubs_, &skipped_,
+                           &hitPattern_, &open_, &valid_, &stubs_})
+      v->clear();
+    for (vector<long long>* v : {&v1_, &x0_, &x1_, &x2_, &x3_, &C00_, &C01_, &C11_, &C22_, &C23_, &C33_, &chi2_})
+      v->clear();
+    frames_.clear();
+  }
+
+  // read in and organize input product
+  void KalmanFilter::consume(const TTDTC::Streams& stubs, const TTDTC::Streams& tracks) {
+    clear();
+    const int numChannel = dataFormats_->numChannel(Process::sf);
+    const int offset = region_ * numChannel;
+    const vector<Field>& fields = dataFormats_->fields(Process::sf);
+    for (int channel = 0; channel < numChannel; channel++) {
+      const TTDTC::Stream& stream = stubs[offset + channel];
+      const TTDTC::Stream& streamTracks = tracks[offset + channel];
+      int numTracks(0);
+      for (auto frame = streamTracks.begin(); frame != streamTracks.end(); frame += DataFormats::numFramesTrack_) {
+        if (frame->first.isNull())
+          continue;
+        // cut on number of input candidates per channel
+        if (numTracks++ == setup_->kfNumTracks())
+          break;
+        const TrackSF track(frame, dataFormats_);
+        const int sectorEta = track.sectorEta();
+        const int track0 = channel_.size();
+        channel_.push_back(channel);
+        sectorPhi_.push_back(track.sectorPhi());
+        sectorEta_.push_back(sectorEta);
+        qOverPt_.push_back(track.qOverPt());
+        phiT_.push_back(track.phiT());
+        cot_.push_back(track.cot());
+        zT_.push_back(track.zT());
+        layerSize_.resize(layerSize_.size() + numLayers_, 0);
+        layerStubs_.resize(layerStubs_.size() + numLayers_ * maxStubsPerLayer_, -1);
+        // seed relative to eta sector centre in half lsbs
+        const long long zT = 2LL * (track.zT() - offsetsZT_[sectorEta]) + 1;
+        const long long cot = 2LL * (track.cot() - offsetsCot_[sectorEta]) + 1;
+        for (int i = track.begin(); i < track.end(); i++) {
+          const TTDTC::Frame& stub = stream[i];
+          const unsigned long long word = stub.second.to_ullong();
+          const int layer = fields[3].integer(word);
+          // cut on number of stubs per layer
+          int& size = layerSize_[track0 * numLayers_ + layer];
+          if (size == maxStubsPerLayer_)
+            continue;
+          const int r = fields[0].integer(word);
+          const int z = fields[2].integer(word);
+          layerStubs_[(track0 * numLayers_ + layer) * maxStubsPerLayer_ + size++] = frames_.size();
+          frames_.push_back(stub);
+          m0_.push_back(fields[1].integer(word));
+          m1_.push_back(z - convert(zT, shiftZT_) - convert(cot * (2LL * r + 1 - leverZT_), shiftCot_));
+          H00_.push_back(-r);
+          H12_.push_back(r - leverR_);
+          layer_.push_back(layer);
+          v1_.push_back(setup_->psModule(stub.first) ? v1PS_ : v12S_);
+        }
+      }
+    }
+  }
+
+  // fill output products
+  void KalmanFilter::produce(TTDTC::Streams& accepted, TTDTC::Streams& tracks) {
+    fit();
+    const int numTracks = channel_.size();
+    // per track finished state with most stubs, smallest chi2 breaks ties, first state wins remaining ties
+    vector<int> best(numTracks, -1);
+    for (int state = 0; state < (int)track_.size(); state++) {
+      if (!valid_[state] || numStubs_[state] < setup_->kfMinLayers())
+        continue;
+      int& b = best[track_[state]];
+      if (b == -1 || numStubs_[state] > numStubs_[b] || (numStubs_[state] == numStubs_[b] && chi2_[state] < chi2_[b]))
+        b = state;
+    }
+    const int offset = region_ * dataFormats_->numChannel(Process::kf);
+    auto inRange = [this](Variable v, int i){ return dataFormats_->format(v, Process::kf).inRange(i); };
+    for (int track = 0; track < numTracks; track++) {
+      const int state = best[track];
+      if (state == -1)
+        continue;
+      const int qOverPt = convert(2LL * qOverPt_[track] + 1, shiftQoverPtKF_) + x0_[state];
+      const int phiT = convert(2LL * phiT_[track] + 1, shiftPhiTKF_) + x1_[state];
+      const int cot = convert(2LL * cot_[track] + 1, shiftCotKF_) + x2_[state];
+      const int zT = convert(2LL * zT_[track] + 1, shiftZTKF_) + x3_[state];
+      if (!inRange(Variable::qOverPt, qOverPt) || !inRange(Variable::phiT, phiT) ||
+          !inRange(Variable::cot, cot) || !inRange(Variable::zT, zT))
+        continue;
+      // kf stubs share the sf stub layout, stubs picked by the fit are forwarded unchanged
+      TTDTC::Stream& stream = accepted[offset + channel_[track]];
+      const int begin = stream.size();
+      for (int i = 0; i < numStubs_[state]; i++)
+        stream.push_back(frames_[stubs_[state * maxLayers_ + i]]);
+      const TrackKF trackKF(stream[begin].first, dataFormats_, sectorPhi_[track], sectorEta_[track],
+                            qOverPt, phiT, cot, zT, hitPattern_[state], begin, stream.size() - begin);
+      trackKF.put(tracks[offset + channel_[track]]);
+    }
+  }
+
+  // propagates all states of the region through all layers
+  void KalmanFilter::fit() {
+    // one initial state per track
+    const int numTracks = channel_.size();
+    track_.resize(numTracks);
+    for (int track = 0; track < numTracks; track++)
+      track_[track] = track;
+    for (vector<int>* v : {&stub_, &numStubs_, &skipped_, &hitPattern_})
+      v->assign(numTracks, 0);
+    open_.assign(numTracks, 1);
+    valid_.assign(numTracks, 1);
+    stubs_.assign(numTracks * maxLayers_, -1);
+    for (vector<long long>* v : {&x0_, &x1_, &x2_, &x3_, &C01_, &C23_, &chi2_})
+      v->assign(numTracks, 0);
+    C00_.assign(numTracks, initC00_);
+    C11_.assign(numTracks, initC11_);
+    C22_.assign(numTracks, initC22_);
+    C33_.assign(numTracks, initC33_);
+    for (int layer = 0; layer < numLayers_; layer++) {
+      const int numStates = track_.size();
+      // every open state branches once per stub of this layer, the pool grows once per layer
+      int numBranches(0);
+      for (int state = 0; state < numStates; state++)
+        if (open_[state])
+          numBranches += layerSize_[track_[state] * numLayers_ + layer];
+      grow(numStates + numBranches);
+      int added = numStates;
+      for (int state = 0; state < numStates; state++) {
+        if (!open_[state])
+          continue;
+        const int index = track_[state] * numLayers_ + layer;
+        for (int i = 0; i < layerSize_[index]; i++)
+          branch(state, added++, layerStubs_[index * maxStubsPerLayer_ + i]);
+        // the state itself skips this layer, it stays a valid result but can not grow any further if too many
+        // layers are skipped
+        if (++skipped_[state] > setup_->kfMaxSkippedLayers())
+          open_[state] = 0;
+      }
+      update(numStates, track_.size());
+    }
+  }
+
+  // resizes the state pool to given number of states, new states are filled by branch
+  void KalmanFilter::grow(int numStates) {
+    for (vector<int>* v : {&track_, &stub_, &numStubs_, &skipped_, &hitPattern_, &open_, &valid_})
+      v->resize(numStates);
+    for (vector<long long>* v : {&x0_, &x1_, &x2_, &x3_, &C00_, &C01_, &C11_, &C22_, &C23_, &C33_, &chi2_})
+      v->resize(numStates);
+    stubs_.resize(numStates * maxLayers_);
+  }
+
+  // copies given state into given new state which is updated with given stub
+  void KalmanFilter::branch(int state, int added, int stub) {
+    for (vector<int>* v : {&track_, &numStubs_, &skipped_, &hitPattern_, &valid_})
+      (*v)[added] = (*v)[state];
+    for (vector<long long>* v : {&x0_, &x1_, &x2_, &x3_, &C00_, &C01_, &C11_, &C22_, &C23_, &C33_, &chi2_})
+      (*v)[added] = (*v)[state];
+    copy_n(next(stubs_.begin(), state * maxLayers_), maxLayers_, next(stubs_.begin(), added * maxLayers_));
+    stubs_[added * maxLayers_ + numStubs_[added]++] = stub;
+    hitPattern_[added] |= 1 << layer_[stub];
+    stub_[added] = stub;
+    open_[added] = numStubs_[added] < maxLayers_;
+  }
+
+  // updates states [begin, end) with their pending stub
+  void KalmanFilter::update(int begin, int end) {
+    const int n = end - begin;
+    for (vector<long long>* v : {&H00s_, &H12s_, &m0s_, &m1s_, &v1s_, &S00s_, &S01s_, &S12s_, &S13s_, &r0s_, &r1s_,
+                                 &invR00s_, &invR11s_})
+      v->resize(n);
+    // state pool and scratch arrays never overlap, ivdep spares the run time alias checks of the passes below
+    // gather stub inputs of pending states into contiguous arrays
+    const int* stub = stub_.data() + begin;
+#pragma GCC ivdep
+    for (int i = 0; i < n; i++) {
+      H00s_[i] = H00_[stub[i]];
+      H12s_[i] = H12_[stub[i]];
+      m0s_[i] = m0_[stub[i]];
+      m1s_[i] = m1_[stub[i]];
+      v1s_[i] = v1_[stub[i]];
+    }
+    long long* x0 = x0_.data() + begin;
+    long long* x1 = x1_.data() + begin;
+    long long* x2 = x2_.data() + begin;
+    long long* x3 = x3_.data() + begin;
+    long long* C00 = C00_.data() + begin;
+    long long* C01 = C01_.data() + begin;
+    long long* C11 = C11_.data() + begin;
+    long long* C22 = C22_.data() + begin;
+    long long* C23 = C23_.data() + begin;
+    long long* C33 = C33_.data() + begin;
+    long long* chi2 = chi2_.data() + begin;
+    const long long* H00 = H00s_.data();
+    const long long* H12 = H12s_.data();
+    const long long* m0 = m0s_.data();
+    const long long* m1 = m1s_.data();
+    const long long* v1 = v1s_.data();
+    long long* S00 = S00s_.data();
+    long long* S01 = S01s_.data();
+    long long* S12 = S12s_.data();
+    long long* S13 = S13s_.data();
+    long long* r0 = r0s_.data();
+    long long* r1 = r1s_.data();
+    long long* R00 = invR00s_.data();
+    long long* R11 = invR11s_.data();
+    const long long v0 = convert(v0_, shiftR00v0_);
+    // residuals and their covariance
+#pragma GCC ivdep
+    for (int i = 0; i < n; i++) {
+      S00[i] = convert(H00[i] * C00[i], shiftS00_) + convert(C01[i], shiftS00C01_);
+      S01[i] = convert(H00[i] * C01[i], shiftS01_) + convert(C11[i], shiftS01C11_);
+      R00[i] = v0 + convert(S01[i], shiftR00S01_) + convert(H00[i] * S00[i], shiftR00_);
+      r0[i] = convert(m0[i], shiftr0m0_) - convert(x1[i], shiftr0x1_) - convert(H00[i] * x0[i], shiftr0_);
+      S12[i] = convert(H12[i] * C22[i], shiftS12_) + convert(C23[i], shiftS12C23_);
+      S13[i] = convert(H12[i] * C23[i], shiftS13_) + convert(C33[i], shiftS13C33_);
+      R11[i] = convert(v1[i], shiftR11v1_) + convert(S13[i], shiftR11S13_) + convert(H12[i] * S12[i], shiftR11_);
+      r1[i] = convert(m1[i], shiftr1m1_) - convert(x3[i], shiftr1x3_) - convert(H12[i] * x2[i], shiftr1_);
+    }
+    // states with non positive residual variance are numerically broken and dropped, residual variances are
+    // replaced by their inverse in place
+    const int widthPhi = setup_->kfWidthLutInvPhi();
+    const int widthZ = setup_->kfWidthLutInvZ();
+#pragma GCC ivdep
+    for (int i = 0; i < n; i++) {
+      const int valid = R00[i] > 0 && R11[i] > 0;
+      valid_[begin + i] &= valid;
+      open_[begin + i] &= valid;
+      R00[i] = invert(valid ? R00[i] : 1, lutInvPhi_, widthPhi, shiftInvR00_);
+      R11[i] = invert(valid ? R11[i] : 1, lutInvZ_, widthZ, shiftInvR11_);
+    }
+    // gain, updated state, covariance and chi2
+#pragma GCC ivdep
+    for (int i = 0; i < n; i++) {
+      const long long K00 = convert(S00[i] * R00[i], shiftK00_);
+      const long long K10 = convert(S01[i] * R00[i], shiftK10_);
+      const long long K21 = convert(S12[i] * R11[i], shiftK21_);
+      const long long K31 = convert(S13[i] * R11[i], shiftK31_);
+      x0[i] += convert(K00 * r0[i], shiftx0_);
+      x1[i] += convert(K10 * r0[i], shiftx1_);
+      x2[i] += convert(K21 * r1[i], shiftx2_);
+      x3[i] += convert(K31 * r1[i], shiftx3_);
+      C00[i] -= convert(K00 * S00[i], shiftC00_);
+      C01[i] -= convert(K00 * S01[i], shiftC01_);
+      C11[i] -= convert(K10 * S01[i], shiftC11_);
+      C22[i] -= convert(K21 * S12[i], shiftC22_);
+      C23[i] -= convert(K21 * S13[i], shiftC23_);
+      C33[i] -= convert(K31 * S13[i], shiftC33_);
+      const long long chi20 = convert(convert(r0[i] * r0[i], shiftr02_) * R00[i], shiftChi20_);
+      const long long chi21 = convert(convert(r1[i] * r1[i], shiftr12_) * R11[i], shiftChi21_);
+      chi2[i] += convert(chi20, shiftChi2r0_) + convert(chi21, shiftChi2r1_);
+    }
+  }
+
+  // 1 / r in given inverse base for r > 0, r is truncated to width bits to address the look up table
+  long long KalmanFilter::invert(long long r, const vector<long long>& lut, int width, int shift) {
+    const int msb = 63 - __builtin_clzll(r);
+    const int e = max(0, msb + 1 - width);
+    return convert(lut[r >> e], 2 * width + e - shift);
+  }
+
+} // namespace trackerTFP
@@ -1,11 +1,13 @@
 #include "L1Trigger/TrackerTFP/interface/LinearFitter.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <tbb/parallel_for.h>
 
 #include <numeric>
 #include <algorithm>
 #include <iterator>
 #include <deque>
 #include <vector>
-#include <set>
 #include <utility>
 #include <cmath>
 
@@ -17,16 +19,40 @@ namespace trackerTFP {
 
   LinearFitter::LinearFitter(const ParameterSet& iConfig, const Setup* setup, const DataFormats* dataFormats, int region) :
     enableTruncation_(iConfig.getParameter<bool>("EnableTruncation")),
+    enableParallel_(iConfig.getParameter<bool>("EnableParallel")),
     setup_(setup),
     dataFormats_(dataFormats),
     qOverPt_(dataFormats_->format(Variable::qOverPt, Process::lf)),
     phiT_(dataFormats_->format(Variable::phiT, Process::lf)),
     region_(region),
-    input_(dataFormats_->numChannel(Process::lf), vector<deque<StubGP*>>(dataFormats_->numChannel(Process::gp)))
-  {}
+    stubsGP_(dataFormats),
+    stubsLF_(dataFormats_->numChannel(Process::lf), StubsLF(dataFormats)),
+    input_(dataFormats_->numChannel(Process::lf), vector<vector<Arrival>>(dataFormats_->numChannel(Process::gp))),
+    mergers_(dataFormats_->numChannel(Process::lf),
+             Merger(2, setup_->htDepthMemory(), enableTruncation_, setup_->numFrames()))
+  {
+    // hit layer patterns are 32 bit masks
+    if (setup_->numLayers() > 32) {
+      cms::Exception exception("BadConfiguration");
+      exception << "Number of layers is " << setup_->numLayers() << " but at most 32 are supported.";
+      exception.addContext("trackerTFP::LinearFitter::LinearFitter");
+      throw exception;
+    }
+  }
+
+  // drop stubs of previous event, allocated memory is kept
+  void LinearFitter::clear() {
+    stubsGP_.clear();
+    for (StubsLF& stubs : stubsLF_)
+      stubs.clear();
+    for (vector<vector<Arrival>>& input : input_)
+      for (vector<Arrival>& stubs : input)
+        stubs.clear();
+  }
 
   // read in and organize input product
   void LinearFitter::consume(const TTDTC::Streams& streams) {
+    clear();
     const int offset = region_ * dataFormats_->numChannel(Process::gp);
     auto validFrame = [](int& sum, const TTDTC::Frame& frame){ return sum += frame.first.isNonnull() ? 1 : 0; };
     int nStubsGP(0);
@@ -38,165 +64,210 @@ namespace trackerTFP {
     for (int sector = 0; sector < dataFormats_->numChannel(Process::gp); sector++) {
       const int sectorPhi = sector % setup_->numSectorsPhi();
       const int sectorEta = sector / setup_->numSectorsPhi();
-      for (const TTDTC::Frame& frame : streams[offset + sector]) {
-        StubGP* stub = nullptr;
-        if (frame.first.isNonnull()) {
-          stubsGP_.emplace_back(frame, dataFormats_, sectorPhi, sectorEta);
-          stub = &stubsGP_.back();
-        }
-        for (int binQoverPt = 0; binQoverPt < dataFormats_->numChannel(Process::lf); binQoverPt++)
-          input_[binQoverPt][sector].push_back(stub && stub->inQoverPtBin(binQoverPt) ? stub : nullptr);
+      const TTDTC::Stream& stream = streams[offset + sector];
+      for (int tick = 0; tick < (int)stream.size(); tick++) {
+        if (stream[tick].first.isNull())
+          continue;
+        const int stub = stubsGP_.size();
+        stubsGP_.emplace_back(stream[tick], sectorPhi, sectorEta);
+        // visit only the qOverPt bins this stub belongs to
+        for (Mask bins = stubsGP_.qOverPtBins(stub); bins; bins &= bins - 1)
+          input_[__builtin_ctzll(bins)][sector].push_back({tick, 0, stub});
       }
     }
-    // remove all gaps between end and last stub
-    for(vector<deque<StubGP*>>& input : input_)
-      for(deque<StubGP*>& stubs : input)
-        for(auto it = stubs.end(); it != stubs.begin();)
-          it = (*--it) ? stubs.begin() : stubs.erase(it);
-    auto validStub = [](int& sum, StubGP* stub){ return sum += stub ? 1 : 0; };
-    int nStubsHT(0);
-    for (const vector<deque<StubGP*>>& binQoverPt : input_)
-      for (const deque<StubGP*>& sector : binQoverPt)
-        nStubsHT += accumulate(sector.begin(), sector.end(), 0, validStub);
-    stubsLF_.reserve(nStubsHT);
+    auto size = [](int& sum, const vector<Arrival>& stubs){ return sum += stubs.size(); };
+    for (int binQoverPt = 0; binQoverPt < dataFormats_->numChannel(Process::lf); binQoverPt++) {
+      const vector<vector<Arrival>>& input = input_[binQoverPt];
+      stubsLF_[binQoverPt].reserve(accumulate(input.begin(), input.end(), 0, size));
+    }
   }
 
   // fill output products
-  void LinearFitter::produce(TTDTC::Streams& accepted, TTDTC::Streams& lost) {
-    for (int binQoverPt = 0; binQoverPt < dataFormats_->numChannel(Process::lf); binQoverPt++) {
-      const int qOverPt = qOverPt_.toSigned(binQoverPt);
-      deque<StubLF*> acceptedAll;
-      deque<StubLF*> lostAll;
-      for (deque<StubGP*>& inputSector : input_[binQoverPt]) {
-        const int size = inputSector.size();
-        vector<StubLF*> acceptedSector;
-        vector<StubLF*> lostSector;
-        acceptedSector.reserve(size);
-        lostSector.reserve(size);
-        // associate stubs with qOverPt and phiT bins
-        fillIn(inputSector, acceptedSector, lostSector, qOverPt);
-        // Process::lf collects all stubs before readout starts -> remove all gaps
-        acceptedSector.erase(remove(acceptedSector.begin(), acceptedSector.end(), nullptr), acceptedSector.end());
-        acceptedSector.shrink_to_fit();
-        lostSector.shrink_to_fit();
-        // identify tracks
-        readOut(acceptedSector, lostSector, acceptedAll, lostAll);
+  void LinearFitter::produce(TTDTC::Streams& accepted, TTDTC::Streams& lost, TTDTC::Streams& tracks) {
+    // each qOverPt bin writes into its own pre-sized output streams only
+    const int numBins = dataFormats_->numChannel(Process::lf);
+    auto process = [this, &accepted, &lost, &tracks](int binQoverPt){ produce(binQoverPt, accepted, lost, tracks); };
+    if (enableParallel_)
+      tbb::parallel_for(0, numBins, process);
+    else
+      for (int binQoverPt = 0; binQoverPt < numBins; binQoverPt++)
+        process(binQoverPt);
+  }
+
+  // find tracks of one qOverPt bin
+  void LinearFitter::produce(int binQoverPt, TTDTC::Streams& accepted, TTDTC::Streams& lost, TTDTC::Streams& tracks) {
+    const StubsLF& stubsLF = stubsLF_[binQoverPt];
+    const int qOverPt = qOverPt_.toSigned(binQoverPt);
+    deque<int> acceptedAll;
+    deque<int> lostAll;
+    // position of first stub of each found track in acceptedAll
+    vector<int> tracksAll;
+    const vector<vector<Arrival>>& input = input_[binQoverPt];
+    const int numSectors = input.size();
+    const int numBinsPhiT = setup_->htNumBinsPhiT();
+    // stubs of sector s occupy [begins[s], begins[s + 1]) of the arrays below
+    vector<int> begins(numSectors + 1, 0);
+    for (int sector = 0; sector < numSectors; sector++)
+      begins[sector + 1] = begins[sector] + input[sector].size();
+    const int size = begins[numSectors];
+    // stub coordinates, layer bits and phiT candidates of all sectors
+    vector<int> phis(size), rs(size), majors(size), minors(size);
+    vector<unsigned int> layers(size);
+    for (int sector = 0; sector < numSectors; sector++) {
+      for (int i = 0, j = begins[sector]; j < begins[sector + 1]; i++, j++) {
+        const int stub = input[sector][i].stub_;
+        phis[j] = stubsGP_.phi(stub);
+        rs[j] = stubsGP_.r(stub);
+        layers[j] = 1U << stubsGP_.layer(stub);
       }
-      // truncate accepted stream
-      const auto limit = enableTruncation_ ? next(acceptedAll.begin(), min(setup_->numFrames(), (int)acceptedAll.size())) : acceptedAll.end();
-      copy_if(limit, acceptedAll.end(), back_inserter(lostAll), [](StubLF* stub){ return stub; });
-      acceptedAll.erase(limit, acceptedAll.end());
-      // store found tracks
-      auto put = [](const deque<StubLF*>& stubs, TTDTC::Stream& stream){
-        stream.reserve(stubs.size());
-        for (StubLF* stub : stubs)
-          stream.emplace_back(stub ? stub->frame() : TTDTC::Frame());
-      };
-      const int offset = region_ * dataFormats_->numChannel(Process::lf);
-      put(acceptedAll, accepted[offset + binQoverPt]);
-      // store lost tracks
-      put(lostAll, lost[offset + binQoverPt]);
+    }
+    // hough transform of all stubs of this qOverPt bin at once
+    dataFormats_->phiT(phis.data(), rs.data(), size, qOverPt, majors.data(), minors.data());
+    // layer pattern per sector and phiT bin accumulated in a single pass,
+    // bins outside of the phiT range (pt < threshold) are ignored
+    vector<unsigned int> patterns(numSectors * numBinsPhiT, 0);
+    for (int sector = 0; sector < numSectors; sector++) {
+      unsigned int* row = patterns.data() + sector * numBinsPhiT;
+      for (int j = begins[sector]; j < begins[sector + 1]; j++) {
+        if (phiT_.inRange(majors[j]))
+          row[phiT_.toUnsigned(majors[j])] |= layers[j];
+        if (phiT_.inRange(minors[j]))
+          row[phiT_.toUnsigned(minors[j])] |= layers[j];
+      }
+    }
+    auto track = [this](unsigned int pattern){ return __builtin_popcount(pattern) >= setup_->htMinLayers(); };
+    for (int sector = 0; sector < numSectors; sector++) {
+      const auto row = next(patterns.begin(), sector * numBinsPhiT);
+      // if no phiT bin reaches htMinLayers no track can be found in this sector, fifo emulation is not needed
+      if (none_of(row, next(row, numBinsPhiT), track))
+        continue;
+      const vector<Arrival>& inputSector = input[sector];
+      vector<int> acceptedSector;
+      vector<int> lostSector;
+      acceptedSector.reserve(2 * inputSector.size());
+      lostSector.reserve(2 * inputSector.size());
+      // associate stubs with qOverPt and phiT bins, Process::lf collects all stubs before readout starts
+      fillIn(inputSector, majors.data() + begins[sector], minors.data() + begins[sector], acceptedSector, lostSector,
+             binQoverPt);
+      // identify tracks
+      readOut(acceptedSector, lostSector, acceptedAll, lostAll, tracksAll, binQoverPt);
+    }
+    // truncate accepted stream
+    const auto limit = enableTruncation_ ? next(acceptedAll.begin(), min(setup_->numFrames(), (int)acceptedAll.size())) : acceptedAll.end();
+    copy_if(limit, acceptedAll.end(), back_inserter(lostAll), [](int stub){ return stub != -1; });
+    acceptedAll.erase(limit, acceptedAll.end());
+    // store found tracks
+    auto put = [&stubsLF](const deque<int>& stubs, TTDTC::Stream& stream){
+      stream.reserve(stubs.size());
+      for (int stub : stubs)
+        stream.emplace_back(stub != -1 ? stubsLF.frame(stub) : TTDTC::Frame());
+    };
+    const int offset = region_ * dataFormats_->numChannel(Process::lf);
+    put(acceptedAll, accepted[offset + binQoverPt]);
+    // store lost tracks
+    put(lostAll, lost[offset + binQoverPt]);
+    // store found tracks as compact records, truncated tracks keep their surviving stubs only
+    const int numStubs = acceptedAll.size();
+    TTDTC::Stream& stream = tracks[offset + binQoverPt];
+    stream.reserve(tracksAll.size() * DataFormats::numFramesTrack_);
+    for (int track = 0; track < (int)tracksAll.size() && tracksAll[track] < numStubs; track++) {
+      const int begin = tracksAll[track];
+      const int end = track + 1 < (int)tracksAll.size() ? min(tracksAll[track + 1], numStubs) : numStubs;
+      int hitPattern(0);
+      for (int i = begin; i < end; i++)
+        hitPattern |= 1 << stubsLF.layer(acceptedAll[i]);
+      const int stub = acceptedAll[begin];
+      const TrackLF trackLF(stubsLF.ttStubRef(stub), dataFormats_, stubsLF.sectorPhi(stub), stubsLF.sectorEta(stub),
+                            qOverPt, stubsLF.phiT(stub), hitPattern, begin, end - begin);
+      trackLF.put(stream);
     }
   }
 
-  // associate stubs with qOverPt and phiT bins
-  void LinearFitter::fillIn(deque<StubGP*>& inputSector, vector<StubLF*>& acceptedSector, vector<StubLF*>& lostSector, int qOverPt) {
-    // fifo, used to store stubs which belongs to a second possible track
-    deque<StubLF*> stack;
-    // clock accurate firmware emulation, each while trip describes one clock tick, one stub in and one stub out per tick
-    while (!inputSector.empty() || !stack.empty()) {
-      StubLF* StubLF = nullptr;
-      StubGP* stubGP = pop_front(inputSector);
-      if (stubGP) {
-        const double phiT = stubGP->phi() + qOverPt_.floating(qOverPt) * stubGP->r();
-        const int major = phiT_.integer(phiT);
-        if (phiT_.inRange(major)) {
-          // major candidate has pt > threshold (3 GeV)
-          stubsLF_.emplace_back(*stubGP, major, qOverPt);
-          StubLF = &stubsLF_.back();
-        }
-        const double chi = phiT - phiT_.floating(major);
-        if (abs(stubGP->r() * qOverPt_.base()) + 2. * abs(chi) >= phiT_.base()) {
-          // stub belongs to two candidates
-          const int minor = chi >= 0. ? major + 1 : major - 1;
-          if (phiT_.inRange(minor)) {
-            // second (minor) candidate has pt > threshold (3 GeV)
-            stubsLF_.emplace_back(*stubGP, minor, qOverPt);
-            if (enableTruncation_ && (int)stack.size() == setup_->htDepthMemory() - 1)
-              // buffer overflow
-              lostSector.push_back(pop_front(stack));
-            // store minor stub in fifo
-            stack.push_back(&stubsLF_.back());
-          }
-        }
+  // associate stubs with qOverPt and phiT bins using precomputed phiT candidates
+  void LinearFitter::fillIn(const vector<Arrival>& inputSector,
+                            const int* majors,
+                            const int* minors,
+                            vector<int>& acceptedSector,
+                            vector<int>& lostSector,
+                            int binQoverPt) {
+    const int qOverPt = qOverPt_.toSigned(binQoverPt);
+    StubsLF& stubsLF = stubsLF_[binQoverPt];
+    // clock accurate firmware emulation, one stub in and one stub out per tick,
+    // a minor stub is taken if no major stub is available
+    int i(0);
+    auto feed = [this, qOverPt, &stubsLF, majors, minors, &i](int, int stubGP, Merger& merger, vector<int>& lost) {
+      // phiT bins are calculated on digitised values
+      const int major = majors[i];
+      const int minor = minors[i++];
+      if (phiT_.inRange(major)) {
+        // major candidate has pt > threshold (3 GeV)
+        merger.push(1, stubsLF.size(), lost);
+        stubsLF.emplace_back(stubsGP_, stubGP, qOverPt, major);
       }
-      // take a minor stub if no major stub available
-      acceptedSector.push_back(StubLF ? StubLF : pop_front(stack));
-    }
-    // truncate to many input stubs
-    const auto limit = enableTruncation_ ? next(acceptedSector.begin(), min(setup_->numFrames(), (int)acceptedSector.size())) : acceptedSector.end();
-    copy_if(limit, acceptedSector.end(), back_inserter(lostSector), [](StubLF* stub){ return stub; });
-    acceptedSector.erase(limit, acceptedSector.end());
+      if (minor != major && phiT_.inRange(minor)) {
+        // stub belongs to two candidates and second (minor) candidate has pt > threshold (3 GeV), store it in fifo
+        merger.push(0, stubsLF.size(), lost);
+        stubsLF.emplace_back(stubsGP_, stubGP, qOverPt, minor);
+      }
+    };
+    mergers_[binQoverPt].run(inputSector, feed, acceptedSector, lostSector);
   }
 
   // identify tracks
-  void LinearFitter::readOut(const vector<StubLF*>& acceptedSector, const vector<StubLF*>& lostSector, deque<StubLF*>& acceptedAll, deque<StubLF*>& lostAll) const {
-    // used to recognise in which order tracks are found
-    TTBV patternPhiTs(0, setup_->htNumBinsPhiT());
-    // hitPattern for all possible tracks, used to find tracks
-    vector<TTBV> patternHits(setup_->htNumBinsPhiT(), TTBV(0, setup_->numLayers()));
+  void LinearFitter::readOut(const vector<int>& acceptedSector,
+                             const vector<int>& lostSector,
+                             deque<int>& acceptedAll,
+                             deque<int>& lostAll,
+                             vector<int>& tracksAll,
+                             int binQoverPt) const {
+    const StubsLF& stubsLF = stubsLF_[binQoverPt];
+    const int numBins = setup_->htNumBinsPhiT();
+    // stubs of all possible tracks, chained per phiT bin in arrival order, indices refer to accepted then lost stubs
+    vector<int> first(numBins, -1);
+    vector<int> last(numBins, -1);
+    vector<int> next(acceptedSector.size() + lostSector.size(), -1);
+    auto stub = [&acceptedSector, &lostSector](int i){
+      return i < (int)acceptedSector.size() ? acceptedSector[i] : lostSector[i - acceptedSector.size()];
+    };
+    auto append = [&first, &last, &next](int binPhiT, int i){
+      (last[binPhiT] == -1 ? first[binPhiT] : next[last[binPhiT]]) = i;
+      last[binPhiT] = i;
+    };
+    // hit layer pattern for all possible tracks
+    vector<unsigned int> patternHits(numBins, 0);
+    // used to recognise which tracks are found
+    vector<bool> found(numBins, false);
     // found unsigned phiTs, ordered in time
     vector<int> binsPhiT;
-    // stub container for all possible tracks
-    vector<vector<StubLF*>> tracks(setup_->htNumBinsPhiT());
-    for (int binPhiT = 0; binPhiT < setup_->htNumBinsPhiT(); binPhiT++) {
-      const int phiT = phiT_.toSigned(binPhiT);
-      auto samePhiT = [phiT](int& sum, StubLF* stub){ return sum += stub->phiT() == phiT; };
-      const int numAccepted = accumulate(acceptedSector.begin(), acceptedSector.end(), 0, samePhiT);
-      const int numLost = accumulate(lostSector.begin(), lostSector.end(), 0, samePhiT);
-      tracks[binPhiT].reserve(numAccepted + numLost);
-    }
-    for (StubLF* stub : acceptedSector) {
-      const int binPhiT = phiT_.toUnsigned(stub->phiT());
-      TTBV& pattern = patternHits[binPhiT];
-      pattern.set(stub->layer());
-      tracks[binPhiT].push_back(stub);
-      if (pattern.count() >= setup_->htMinLayers() && !patternPhiTs[binPhiT]) {
+    for (int i = 0; i < (int)acceptedSector.size(); i++) {
+      const int binPhiT = phiT_.toUnsigned(stubsLF.phiT(acceptedSector[i]));
+      unsigned int& pattern = patternHits[binPhiT];
+      pattern |= 1U << stubsLF.layer(acceptedSector[i]);
+      append(binPhiT, i);
+      if (!found[binPhiT] && __builtin_popcount(pattern) >= setup_->htMinLayers()) {
         // first time track found
-        patternPhiTs.set(binPhiT);
+        found[binPhiT] = true;
         binsPhiT.push_back(binPhiT);
       }
     }
     // read out found tracks ordered as found
     for (int binPhiT : binsPhiT) {
-      const vector<StubLF*>& track = tracks[binPhiT];
-      acceptedAll.insert(acceptedAll.end(), track.begin(), track.end());
+      tracksAll.push_back(acceptedAll.size());
+      for (int i = first[binPhiT]; i != -1; i = next[i])
+        acceptedAll.push_back(stub(i));
     }
     // look for lost tracks
-    for (StubLF* stub : lostSector) {
-      const int binPhiT = phiT_.toUnsigned(stub->phiT());
-      if (!patternPhiTs[binPhiT])
-        tracks[binPhiT].push_back(stub);
-    }
-    for (int binPhiT : patternPhiTs.ids(false)) {
-      const vector<StubLF*>& track = tracks[binPhiT];
-      set<int> layers;
-      auto toLayer = [](StubLF* stub){ return stub->layer(); };
-      transform(track.begin(), track.end(), inserter(layers, layers.begin()), toLayer);
-      if ((int)layers.size() >= setup_->htMinLayers())
-        lostAll.insert(lostAll.end(), track.begin(), track.end());
-    }
-  }
-
-  // remove and return first element of deque, returns nullptr if empty
-  template<class T>
-  T* LinearFitter::pop_front(deque<T*>& ts) const {
-    T* t = nullptr;
-    if (!ts.empty()) {
-      t = ts.front();
-      ts.pop_front();
+    for (int i = 0; i < (int)lostSector.size(); i++) {
+      const int binPhiT = phiT_.toUnsigned(stubsLF.phiT(lostSector[i]));
+      if (found[binPhiT])
+        continue;
+      patternHits[binPhiT] |= 1U << stubsLF.layer(lostSector[i]);
+      append(binPhiT, acceptedSector.size() + i);
     }
-    return t;
+    for (int binPhiT = 0; binPhiT < numBins; binPhiT++)
+      if (!found[binPhiT] && __builtin_popcount(patternHits[binPhiT]) >= setup_->htMinLayers())
+        for (int i = first[binPhiT]; i != -1; i = next[i])
+          lostAll.push_back(stub(i));
   }
 
 } // namespace trackerTFP
\ No newline at end of file
@@ -0,0 +1,302 @@
+#include "L1Trigger/TrackerTFP/interface/LinearRegression.h"
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+using namespace edm;
+using namespace trackerDTC;
+
+namespace trackerTFP {
+
+  LinearRegression::LinearRegression(const ParameterSet& iConfig,
+                                     const Setup* setup,
+                                     const DataFormats* dataFormats,
+                                     int region) :
+    setup_(setup),
+    dataFormats_(dataFormats),
+    region_(region),
+    numTracks_(0),
+    numSlots_(0)
+  {
+    const double basePhiT = dataFormats_->base(Variable::phiT, Process::lf);
+    const double baseQoverPt = dataFormats_->base(Variable::qOverPt, Process::lf);
+    const double basePhi = dataFormats_->base(Variable::phi, Process::lf);
+    const double baseR = dataFormats_->base(Variable::r, Process::lf);
+    const double baseZ = dataFormats_->base(Variable::z, Process::gp);
+    residPhi_ = max(1., floor(setup_->lrResidPhi() / basePhi * 2.));
+    residZPS_ = max(1., floor(setup_->lrResidZPS() / baseZ * 2.));
+    residZ2S_ = max(1., floor(setup_->lrResidZ2S() / baseZ * 2.));
+    // stub phi and r are given in half lsbs, all bases involved are power of two multiples of each other
+    const int shiftPhi = DataFormats::exponent(basePhi / basePhiT, "stub phi");
+    const int shiftR = DataFormats::exponent(baseQoverPt * baseR / basePhiT, "qOverPt * r");
+    // lr phiT = (phiT + .5) * 2^-diffPhiT + interceptPhi / 2 * 2^(shiftPhi - diffPhiT)
+    shiftPhiT_ = -setup_->lrBaseDiffPhiT() - 1;
+    shiftInterceptPhi_ = shiftPhi - setup_->lrBaseDiffPhiT() - 1;
+    // lr qOverPt = (qOverPt + .5) * 2^-diffQoverPt - slopePhi * 2^(shiftPhi - shiftR - diffQoverPt)
+    shiftQoverPt_ = -setup_->lrBaseDiffQoverPt() - 1;
+    shiftSlopePhi_ = shiftPhi - shiftR - setup_->lrBaseDiffQoverPt();
+    // lr cot = sector cot + slopeZ * 2^-diffCot, lr zT = sector zT + (interceptZ + slopeZ * lever) / 2 * 2^-diffZT
+    shiftSlopeZ_ = -setup_->lrBaseDiffCot();
+    shiftInterceptZ_ = -setup_->lrBaseDiffZT() - 1;
+    leverZT_ = lround((setup_->chosenRofZ() - setup_->chosenRofPhi()) / baseR * 2.);
+    const double baseCot = dataFormats_->base(Variable::cot, Process::lr);
+    const double baseZT = dataFormats_->base(Variable::zT, Process::lr);
+    offsetsCot_.reserve(setup_->numSectorsEta());
+    offsetsZT_.reserve(setup_->numSectorsEta());
+    for (int sectorEta = 0; sectorEta < setup_->numSectorsEta(); sectorEta++) {
+      const double cot = setup_->sectorCot(sectorEta);
+      offsetsCot_.push_back(floor(cot / baseCot + .5));
+      offsetsZT_.push_back(floor(cot * setup_->chosenRofZ() / baseZT + .5));
+    }
+  }
+
+  // drop tracks of previous event, allocated memory is kept
+  void LinearRegression::clear() {
+    numTracks_ = 0;
+    numSlots_ = 0;
+    for (vector<int>* v : {&channel_, &sectorPhi_, &sectorEta_, &qOverPt_, &phiT_, &open_, &pattern_, &patternPS_,
+                           &worst_, &qOverPtLR_, &phiTLR_, &cotLR_, &zTLR_, &layer_, &ps_, &active_})
+      v->clear();
+    for (vector<long long>* v : {&n_, &sumR_, &sumRR_, &sumPhi_, &sumRPhi_, &nPS_, &sumRPS_, &sumRRPS_, &sumZ_, &sumRZ_,
+                                 &r_, &phi_, &z_, &interceptPhi_, &slopePhi_, &denPhi_, &interceptZ_, &slopeZ_, &denZ_,
+                                 &cutPhi_, &cutZPS_, &cutZ2S_, &score_})
+      v->clear();
+    valid_.clear();
+    ttStubRefs_.clear();
+  }
+
+  // read in and organize input product
+  void LinearRegression::consume(const TTDTC::Streams& stubs, const TTDTC::Streams& tracks) {
+    clear();
+    const int numChannel = dataFormats_->numChannel(Process::lf);
+    const int offset = region_ * numChannel;
+    for (int channel = 0; channel < numChannel; channel++) {
+      const TTDTC::Stream& streamTracks = tracks[offset + channel];
+      for (auto frame = streamTracks.begin(); frame != streamTracks.end(); frame += DataFormats::numFramesTrack_) {
+        if (frame->first.isNull())
+          continue;
+        const TrackLF track(frame, dataFormats_);
+        channel_.push_back(channel);
+        sectorPhi_.push_back(track.sectorPhi());
+        sectorEta_.push_back(track.sectorEta());
+        qOverPt_.push_back(track.qOverPt());
+        phiT_.push_back(track.phiT());
+        numSlots_ = max(numSlots_, track.size());
+      }
+    }
+    numTracks_ = channel_.size();
+    const int size = numSlots_ * numTracks_;
+    ttStubRefs_.resize(size);
+    for (vector<long long>* v : {&r_, &phi_, &z_})
+      v->assign(size, 0);
+    for (vector<int>* v : {&layer_, &ps_, &active_})
+      v->assign(size, 0);
+    // stubs of track i occupy slots [0, size) of column i
+    const vector<Field>& fields = dataFormats_->fields(Process::lf);
+    int track(0);
+    for (int channel = 0; channel < numChannel; channel++) {
+      const TTDTC::Stream& stream = stubs[offset + channel];
+      const TTDTC::Stream& streamTracks = tracks[offset + channel];
+      for (auto frame = streamTracks.begin(); frame != streamTracks.end(); frame += DataFormats::numFramesTrack_) {
+        if (frame->first.isNull())
+          continue;
+        const TrackLF trackLF(frame, dataFormats_);
+        for (int slot = 0; slot < trackLF.size(); slot++) {
+          const TTDTC::Frame& stub = stream[trackLF.begin() + slot];
+          const unsigned long long word = stub.second.to_ullong();
+          const int i = slot * numTracks_ + track;
+          ttStubRefs_[i] = stub.first;
+          r_[i] = 2 * fields[0].integer(word) + 1;
+          phi_[i] = 2 * fields[1].integer(word) + 1;
+          z_[i] = 2 * fields[2].integer(word) + 1;
+          layer_[i] = fields[3].integer(word);
+          ps_[i] = setup_->psModule(stub.first);
+          active_[i] = 1;
+        }
+        track++;
+      }
+    }
+  }
+
+  // fill output products
+  void LinearRegression::produce(TTDTC::Streams& accepted, TTDTC::Streams& tracks) {
+    fit();
+    const int offset = region_ * dataFormats_->numChannel(Process::lr);
+    const vector<Field>& fields = dataFormats_->fields(Process::lr);
+    for (int track = 0; track < numTracks_; track++) {
+      if (!valid_[track])
+        continue;
+      TTDTC::Stream& stream = accepted[offset + channel_[track]];
+      const int begin = stream.size();
+      int first(-1);
+      for (int slot = 0; slot < numSlots_; slot++) {
+        const int i = slot * numTracks_ + track;
+        if (!active_[i])
+          continue;
+        if (first == -1)
+          first = i;
+        // stub residuals to fitted track
+        const long long residPhi = phi_[i] * denPhi_[track] - interceptPhi_[track] - slopePhi_[track] * r_[i];
+        const long long residZ = z_[i] * denZ_[track] - interceptZ_[track] - slopeZ_[track] * r_[i];
+        unsigned long long word(0);
+        fields[0].attach((int)((r_[i] - 1) / 2), word);
+        fields[1].attach((int)floorDiv(residPhi, 2 * denPhi_[track]), word);
+        fields[2].attach((int)floorDiv(residZ, 2 * denZ_[track]), word);
+        fields[3].attach(layer_[i], word);
+        stream.emplace_back(ttStubRefs_[i], TTDTC::BV(word));
+      }
+      const TrackLR trackLR(ttStubRefs_[first], dataFormats_, sectorPhi_[track], sectorEta_[track],
+                            qOverPtLR_[track], phiTLR_[track], cotLR_[track], zTLR_[track],
+                            pattern_[track], begin, stream.size() - begin);
+      trackLR.put(tracks[offset + channel_[track]]);
+    }
+  }
+
+  // fits all tracks of the region at once
+  void LinearRegression::fit() {
+    open_.assign(numTracks_, 1);
+    valid_.assign(numTracks_, false);
+    for (vector<int>* v : {&qOverPtLR_, &phiTLR_, &cotLR_, &zTLR_})
+      v->assign(numTracks_, 0);
+    for (int iteration = 0; any_of(open_.begin(), open_.end(), [](int open){ return open; }); iteration++) {
+      sums();
+      residuals();
+      for (int track = 0; track < numTracks_; track++) {
+        if (!open_[track])
+          continue;
+        const bool enoughLayers = __builtin_popcount(pattern_[track]) >= setup_->lrMinLayers();
+        const bool enoughLayersPS = __builtin_popcount(patternPS_[track]) >= setup_->lrMinLayersPS();
+        if (!enoughLayers || !enoughLayersPS || denPhi_[track] <= 0 || denZ_[track] <= 0)
+          close(track, false);
+        else if (score_[track] <= 1LL << widthScore_ || iteration == setup_->lrNumIterations())
+          close(track, true);
+        else
+          // remove worst stub and fit again
+          active_[worst_[track] * numTracks_ + track] = 0;
+      }
+    }
+  }
+
+  // calculates regression sums of active stubs and hit layer patterns of all tracks
+  void LinearRegression::sums() {
+    for (vector<long long>* v :
+         {&n_, &sumR_, &sumRR_, &sumPhi_, &sumRPhi_, &nPS_, &sumRPS_, &sumRRPS_, &sumZ_, &sumRZ_})
+      v->assign(numTracks_, 0);
+    pattern_.assign(numTracks_, 0);
+    patternPS_.assign(numTracks_, 0);
+    const int numTracks = numTracks_;
+    const int* active = active_.data();
+    const int* ps = ps_.data();
+    const int* layer = layer_.data();
+    const long long* r = r_.data();
+    const long long* phi = phi_.data();
+    const long long* z = z_.data();
+    long long* n = n_.data();
+    long long* sumR = sumR_.data();
+    long long* sumRR = sumRR_.data();
+    long long* sumPhi = sumPhi_.data();
+    long long* sumRPhi = sumRPhi_.data();
+    long long* nPS = nPS_.data();
+    long long* sumRPS = sumRPS_.data();
+    long long* sumRRPS = sumRRPS_.data();
+    long long* sumZ = sumZ_.data();
+    long long* sumRZ = sumRZ_.data();
+    int* pattern = pattern_.data();
+    int* patternPS = patternPS_.data();
+    // sums and stub data live in distinct arrays, ivdep spares the run time alias checks
+    for (int slot = 0; slot < numSlots_; slot++) {
+      const int offset = slot * numTracks;
+#pragma GCC ivdep
+      for (int track = 0; track < numTracks; track++) {
+        const int i = offset + track;
+        const long long w = active[i];
+        const long long wPS = active[i] & ps[i];
+        const long long wR = w * r[i];
+        const long long wRPS = wPS * r[i];
+        n[track] += w;
+        sumR[track] += wR;
+        sumRR[track] += wR * r[i];
+        sumPhi[track] += w * phi[i];
+        sumRPhi[track] += wR * phi[i];
+        nPS[track] += wPS;
+        sumRPS[track] += wRPS;
+        sumRRPS[track] += wRPS * r[i];
+        sumZ[track] += wPS * z[i];
+        sumRZ[track] += wRPS * z[i];
+      }
+    }
+    for (int slot = 0; slot < numSlots_; slot++) {
+      const int offset = slot * numTracks;
+#pragma GCC ivdep
+      for (int track = 0; track < numTracks; track++) {
+        const int i = offset + track;
+        pattern[track] |= active[i] << layer[i];
+        patternPS[track] |= (active[i] & ps[i]) << layer[i];
+      }
+    }
+  }
+
+  // calculates fit parameter and finds per track the stub with largest normalised residual
+  void LinearRegression::residuals() {
+    for (vector<long long>* v : {&interceptPhi_, &slopePhi_, &denPhi_, &interceptZ_, &slopeZ_, &denZ_,
+                                 &cutPhi_, &cutZPS_, &cutZ2S_, &score_})
+      v->resize(numTracks_);
+    worst_.assign(numTracks_, 0);
+    for (int track = 0; track < numTracks_; track++) {
+      denPhi_[track] = n_[track] * sumRR_[track] - sumR_[track] * sumR_[track];
+      interceptPhi_[track] = sumPhi_[track] * sumRR_[track] - sumR_[track] * sumRPhi_[track];
+      slopePhi_[track] = n_[track] * sumRPhi_[track] - sumR_[track] * sumPhi_[track];
+      denZ_[track] = nPS_[track] * sumRRPS_[track] - sumRPS_[track] * sumRPS_[track];
+      interceptZ_[track] = sumZ_[track] * sumRRPS_[track] - sumRPS_[track] * sumRZ_[track];
+      slopeZ_[track] = nPS_[track] * sumRZ_[track] - sumRPS_[track] * sumZ_[track];
+      // singular fits are rejected later, cuts are kept positive to keep divisions defined
+      cutPhi_[track] = max(1LL, residPhi_ * denPhi_[track]);
+      cutZPS_[track] = max(1LL, residZPS_ * denZ_[track]);
+      cutZ2S_[track] = max(1LL, residZ2S_ * denZ_[track]);
+      score_[track] = 0;
+    }
+    for (int slot = 0; slot < numSlots_; slot++) {
+      const int offset = slot * numTracks_;
+      for (int track = 0; track < numTracks_; track++) {
+        const int i = offset + track;
+        const long long residPhi = phi_[i] * denPhi_[track] - interceptPhi_[track] - slopePhi_[track] * r_[i];
+        const long long residZ = z_[i] * denZ_[track] - interceptZ_[track] - slopeZ_[track] * r_[i];
+        const long long scorePhi = (abs(residPhi) << widthScore_) / cutPhi_[track];
+        const long long scoreZ = (abs(residZ) << widthScore_) / (ps_[i] ? cutZPS_[track] : cutZ2S_[track]);
+        const long long score = active_[i] * max(scorePhi, scoreZ);
+        if (score > score_[track]) {
+          score_[track] = score;
+          worst_[track] = slot;
+        }
+      }
+    }
+  }
+
+  // closes given track, stores digitised track parameter if valid and in range
+  void LinearRegression::close(int track, bool valid) {
+    open_[track] = 0;
+    if (!valid)
+      return;
+    const int sectorEta = sectorEta_[track];
+    const long long den = denPhi_[track];
+    const long long denZ = denZ_[track];
+    const long long interceptZ = interceptZ_[track] + slopeZ_[track] * leverZT_;
+    phiTLR_[track] = digitise(2 * phiT_[track] + 1, shiftPhiT_, interceptPhi_[track], den, shiftInterceptPhi_);
+    qOverPtLR_[track] = digitise(2 * qOverPt_[track] + 1, shiftQoverPt_, -slopePhi_[track], den, shiftSlopePhi_);
+    cotLR_[track] = digitise(offsetsCot_[sectorEta], 0, slopeZ_[track], denZ, shiftSlopeZ_);
+    zTLR_[track] = digitise(offsetsZT_[sectorEta], 0, interceptZ, denZ, shiftInterceptZ_);
+    auto inRange = [this](Variable v, int i){ return dataFormats_->format(v, Process::lr).inRange(i); };
+    valid_[track] = inRange(Variable::phiT, phiTLR_[track]) && inRange(Variable::qOverPt, qOverPtLR_[track]) &&
+                    inRange(Variable::cot, cotLR_[track]) && inRange(Variable::zT, zTLR_[track]);
+  }
+
+  // floor(cell * 2^shiftCell + num / den * 2^shiftNum) for den > 0
+  int LinearRegression::digitise(long long cell, int shiftCell, long long num, long long den, int shiftNum) {
+    const int shift = min({0, shiftCell, shiftNum});
+    const long long numerator = cell * den * (1LL << (shiftCell - shift)) + num * (1LL << (shiftNum - shift));
+    return floorDiv(numerator, den * (1LL << -shift));
+  }
+
+} // namespace trackerTFP
@@ -0,0 +1,89 @@
+#include "L1Trigger/TrackerTFP/interface/Merger.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+namespace trackerTFP {
+
+  Merger::Merger(int numChannel, int depth, bool enableTruncation, int numFrames) :
+    numChannel_(numChannel),
+    depth_(depth),
+    enableTruncation_(enableTruncation),
+    numFrames_(numFrames),
+    capacity_(1),
+    head_(numChannel_, 0),
+    size_(numChannel_, 0),
+    occupancy_(0),
+    maxOccupancy_(numChannel_, 0),
+    numOverflows_(0),
+    numTruncated_(0)
+  {
+    if (numChannel_ > 64) {
+      cms::Exception exception("BadConfiguration");
+      exception << "Number of merger input channels is " << numChannel_ << " but at most 64 are supported.";
+      exception.addContext("trackerTFP::Merger::Merger");
+      throw exception;
+    }
+    while (capacity_ < depth_)
+      capacity_ *= 2;
+    buffer_.assign(numChannel_ * capacity_, -1);
+  }
+
+  void Merger::clear() {
+    fill(head_.begin(), head_.end(), 0);
+    fill(size_.begin(), size_.end(), 0);
+    occupancy_ = 0;
+    truncated_.clear();
+  }
+
+  void Merger::push(int channel, int stub, vector<int>& lost) {
+    int& size = size_[channel];
+    if (enableTruncation_ && size > 0 && size == depth_ - 1) {
+      // buffer overflow
+      lost.push_back(pop(channel));
+      numOverflows_++;
+    }
+    if (size == capacity_)
+      grow();
+    buffer_[channel * capacity_ + ((head_[channel] + size) & (capacity_ - 1))] = stub;
+    size++;
+    occupancy_ |= 1ULL << channel;
+    maxOccupancy_[channel] = max(maxOccupancy_[channel], size);
+  }
+
+  int Merger::pop() {
+    if (occupancy_ == 0)
+      return -1;
+    return pop(63 - __builtin_clzll(occupancy_));
+  }
+
+  int Merger::pop(int channel) {
+    int& head = head_[channel];
+    const int stub = buffer_[channel * capacity_ + head];
+    head = (head + 1) & (capacity_ - 1);
+    if (--size_[channel] == 0)
+      occupancy_ &= ~(1ULL << channel);
+    return stub;
+  }
+
+  void Merger::resetStatistics() {
+    fill(maxOccupancy_.begin(), maxOccupancy_.end(), 0);
+    numOverflows_ = 0;
+    numTruncated_ = 0;
+  }
+
+  void Merger::grow() {
+    vector<int> buffer(numChannel_ * capacity_ * 2, -1);
+    for (int channel = 0; channel < numChannel_; channel++) {
+      for (int i = 0; i < size_[channel]; i++)
+        buffer[channel * capacity_ * 2 + i] = buffer_[channel * capacity_ + ((head_[channel] + i) & (capacity_ - 1))];
+      head_[channel] = 0;
+    }
+    capacity_ *= 2;
+    buffer_ = move(buffer);
+  }
+
+}  // namespace trackerTFP
@@ -0,0 +1,241 @@
+#include "L1Trigger/TrackerTFP/interface/MiniHoughTransform.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+using namespace edm;
+using namespace trackerDTC;
+
+namespace trackerTFP {
+
+  MiniHoughTransform::MiniHoughTransform(const ParameterSet& iConfig,
+                                         const Setup* setup,
+                                         const DataFormats* dataFormats,
+                                         int region) :
+    enableTruncation_(iConfig.getParameter<bool>("EnableTruncation")),
+    setup_(setup),
+    dataFormats_(dataFormats),
+    region_(region),
+    numChannel_(dataFormats_->numChannel(Process::mht)),
+    streams_(numChannel_),
+    buffer_(numChannel_),
+    lost_(numChannel_)
+  {
+    const int numNodes = setup_->mhtNumDLBNodes();
+    const int numNodeChannel = setup_->mhtNumDLBChannel();
+    if (numNodes * numNodeChannel != numChannel_) {
+      cms::Exception exception("BadConfiguration");
+      exception << "DLB nodes connect " << numNodes * numNodeChannel << " channels but " << numChannel_
+                << " MHT channels are used.";
+      exception.addContext("trackerTFP::MiniHoughTransform::MiniHoughTransform");
+      throw exception;
+    }
+    // butterfly network, the stride between channels of a node grows by numDLBChannel with each step
+    nodes_.reserve(setup_->mhtNumDLBs());
+    int stride(1);
+    for (int step = 0; step < setup_->mhtNumDLBs(); step++) {
+      if (numChannel_ % (stride * numNodeChannel) != 0)
+        stride = 1;
+      vector<vector<int>> nodes(numNodes);
+      for (int node = 0; node < numNodes; node++) {
+        const int base = node / stride * stride * numNodeChannel + node % stride;
+        for (int channel = 0; channel < numNodeChannel; channel++)
+          nodes[node].push_back(base + channel * stride);
+      }
+      nodes_.push_back(nodes);
+      stride *= numNodeChannel;
+    }
+    // no dedicated mht memory depth is configured, dlb fifos are sized as ht fifos
+    mergers_.reserve(numNodes);
+    for (int node = 0; node < numNodes; node++)
+      mergers_.emplace_back(numNodeChannel, setup_->htDepthMemory(), enableTruncation_, setup_->numFrames());
+  }
+
+  // drop stubs of previous event, allocated memory is kept
+  void MiniHoughTransform::clear() {
+    ttStubRefs_.clear();
+    for (vector<int>* v : {&r_, &phi_, &z_, &layer_, &track_, &sectorPhi_, &sectorEta_, &qOverPt_, &phiT_, &route_})
+      v->clear();
+    for (vector<vector<int>>* streams : {&streams_, &buffer_, &lost_})
+      for (vector<int>& stream : *streams)
+        stream.clear();
+  }
+
+  // read in and organize input product
+  void MiniHoughTransform::consume(const TTDTC::Streams& stubs, const TTDTC::Streams& tracks) {
+    clear();
+    const int offset = region_ * dataFormats_->numChannel(Process::lf);
+    for (int channel = 0; channel < numChannel_; channel++) {
+      const TTDTC::Stream& stream = stubs[offset + channel];
+      const TTDTC::Stream& streamTracks = tracks[offset + channel];
+      int tick(0);
+      for (auto frame = streamTracks.begin(); frame != streamTracks.end(); frame += DataFormats::numFramesTrack_)
+        if (frame->first.isNonnull())
+          fill(channel, TrackLF(frame, dataFormats_), stream, tick);
+    }
+  }
+
+  // finds fine candidates of given lf track, their stubs are sent serially through given channel
+  void MiniHoughTransform::fill(int channel, const TrackLF& trackLF, const TTDTC::Stream& stream, int& tick) {
+    const int numBinsQoverPt = setup_->mhtNumBinsQoverPt();
+    const int numBinsPhiT = setup_->mhtNumBinsPhiT();
+    const int size = trackLF.size();
+    const vector<Field>& fields = dataFormats_->fields(Process::lf);
+    // fine cell and phi residual per lf stub and fine qOverPt bin, -1 if outside of lf cell
+    cells_.assign(numBinsQoverPt * size, -1);
+    phis_.assign(numBinsQoverPt * size, 0);
+    patterns_.assign(setup_->mhtNumCells(), 0);
+    for (int i = 0; i < size; i++) {
+      const unsigned long long word = stream[trackLF.begin() + i].second.to_ullong();
+      const int r = fields[0].integer(word);
+      const int layer = fields[3].integer(word);
+      for (int binQoverPt = 0; binQoverPt < numBinsQoverPt; binQoverPt++) {
+        int phi = fields[1].integer(word);
+        const int binPhiT = dataFormats_->phiTMHT(phi, r, binQoverPt);
+        const bool inCell = binPhiT >= 0 && binPhiT < numBinsPhiT;
+        const int cell = binQoverPt * numBinsPhiT + binPhiT;
+        cells_[binQoverPt * size + i] = inCell ? cell : -1;
+        phis_[binQoverPt * size + i] = phi;
+        if (inCell)
+          patterns_[cell] |= 1U << layer;
+      }
+    }
+    // candidate stubs are sent after the lf track is received completely
+    tick = max(tick, trackLF.end());
+    vector<int>& streamMHT = streams_[channel];
+    for (int cell = 0; cell < setup_->mhtNumCells(); cell++) {
+      if (__builtin_popcount(patterns_[cell]) < setup_->mhtMinLayers())
+        continue;
+      const int binQoverPt = cell / numBinsPhiT;
+      const int binPhiT = cell % numBinsPhiT;
+      const int track = sectorPhi_.size();
+      sectorPhi_.push_back(trackLF.sectorPhi());
+      sectorEta_.push_back(trackLF.sectorEta());
+      qOverPt_.push_back(trackLF.qOverPt() * numBinsQoverPt + binQoverPt);
+      phiT_.push_back(trackLF.phiT() * numBinsPhiT + binPhiT);
+      for (int i = 0; i < size; i++) {
+        if (cells_[binQoverPt * size + i] != cell)
+          continue;
+        const TTDTC::Frame& frame = stream[trackLF.begin() + i];
+        const unsigned long long word = frame.second.to_ullong();
+        streamMHT.resize(tick, -1);
+        streamMHT.push_back(ttStubRefs_.size());
+        tick++;
+        ttStubRefs_.push_back(frame.first);
+        r_.push_back(fields[0].integer(word));
+        phi_.push_back(phis_[binQoverPt * size + i]);
+        z_.push_back(fields[2].integer(word));
+        layer_.push_back(fields[3].integer(word));
+        track_.push_back(track);
+      }
+    }
+  }
+
+  // fill output products
+  void MiniHoughTransform::produce(TTDTC::Streams& accepted, TTDTC::Streams& lost, TTDTC::Streams& tracks) {
+    for (int step = 0; step < (int)nodes_.size(); step++)
+      balance(step);
+    const int offset = region_ * numChannel_;
+    for (int channel = 0; channel < numChannel_; channel++) {
+      const vector<int>& stream = streams_[channel];
+      TTDTC::Stream& streamAccepted = accepted[offset + channel];
+      TTDTC::Stream& streamTracks = tracks[offset + channel];
+      streamAccepted.reserve(stream.size());
+      for (int stub : stream)
+        streamAccepted.emplace_back(stub != -1 ? frame(stub) : TTDTC::Frame());
+      // tracks are contiguous, truncated tracks keep their surviving stubs only
+      for (int begin = 0; begin < (int)stream.size();) {
+        if (stream[begin] == -1) {
+          begin++;
+          continue;
+        }
+        const int track = track_[stream[begin]];
+        int end(begin);
+        int hitPattern(0);
+        for (; end < (int)stream.size() && stream[end] != -1 && track_[stream[end]] == track; end++)
+          hitPattern |= 1 << layer_[stream[end]];
+        const TrackMHT trackMHT(ttStubRefs_[stream[begin]], dataFormats_, sectorPhi_[track], sectorEta_[track],
+                                qOverPt_[track], phiT_[track], hitPattern, begin, end - begin);
+        trackMHT.put(streamTracks);
+        begin = end;
+      }
+      TTDTC::Stream& streamLost = lost[offset + channel];
+      streamLost.reserve(lost_[channel].size());
+      for (int stub : lost_[channel])
+        streamLost.push_back(frame(stub));
+    }
+  }
+
+  // emulates one dynamic load balancing step
+  void MiniHoughTransform::balance(int step) {
+    route_.assign(sectorPhi_.size(), -1);
+    for (int node = 0; node < (int)nodes_[step].size(); node++) {
+      const vector<int>& channels = nodes_[step][node];
+      const int numNodeChannel = channels.size();
+      Merger& merger = mergers_[node];
+      merger.clear();
+      // per input the track currently received, per output the track currently filled in
+      vector<int> received(numNodeChannel, -1);
+      vector<int> locked(numNodeChannel, -1);
+      int length(0);
+      for (int channel : channels)
+        length = max(length, (int)streams_[channel].size());
+      // each trip describes one clock tick
+      for (int tick = 0; tick < length || !merger.empty(); tick++) {
+        for (int input = 0; input < numNodeChannel; input++) {
+          const vector<int>& stream = streams_[channels[input]];
+          const int stub = tick < (int)stream.size() ? stream[tick] : -1;
+          const int track = stub != -1 ? track_[stub] : -1;
+          // an output is released once the track filling it ended
+          if (received[input] != -1 && received[input] != track)
+            locked[route_[received[input]]] = -1;
+          received[input] = track;
+          if (stub == -1)
+            continue;
+          int& route = route_[track];
+          if (route == -1) {
+            // first stub of track, choose least filled free output, preferring the input's own channel
+            for (int output = 0; output < numNodeChannel; output++) {
+              if (locked[output] != -1)
+                continue;
+              if (route == -1 || merger.size(output) < merger.size(route) ||
+                  (merger.size(output) == merger.size(route) && output == input))
+                route = output;
+            }
+            locked[route] = track;
+          }
+          merger.push(route, stub, lost_[channels[route]]);
+        }
+        for (int output = 0; output < numNodeChannel; output++) {
+          if (merger.empty(output))
+            continue;
+          const int stub = merger.pop(output);
+          if (enableTruncation_ && tick >= setup_->numFrames()) {
+            lost_[channels[output]].push_back(stub);
+            continue;
+          }
+          vector<int>& stream = buffer_[channels[output]];
+          stream.resize(tick, -1);
+          stream.push_back(stub);
+        }
+      }
+    }
+    swap(streams_, buffer_);
+    for (vector<int>& stream : buffer_)
+      stream.clear();
+  }
+
+  // bit accurate MHT stub
+  TTDTC::Frame MiniHoughTransform::frame(int stub) const {
+    const vector<Field>& fields = dataFormats_->fields(Process::mht);
+    unsigned long long word(0);
+    fields[0].attach(r_[stub], word);
+    fields[1].attach(phi_[stub], word);
+    fields[2].attach(z_[stub], word);
+    fields[3].attach(layer_[stub], word);
+    return TTDTC::Frame(ttStubRefs_[stub], TTDTC::BV(word));
+  }
+
+} // namespace trackerTFP
@@ -0,0 +1,194 @@
+#include "L1Trigger/TrackerTFP/interface/SeedFilter.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+using namespace edm;
+using namespace trackerDTC;
+
+namespace trackerTFP {
+
+  SeedFilter::SeedFilter(const ParameterSet& iConfig, const Setup* setup, const DataFormats* dataFormats, int region) :
+    setup_(setup),
+    dataFormats_(dataFormats),
+    region_(region)
+  {
+    // seed pairs are tabulated per PS layer pattern
+    if (setup_->numLayers() > 16) {
+      cms::Exception exception("BadConfiguration");
+      exception << "Number of layers is " << setup_->numLayers() << " but at most 16 are supported.";
+      exception.addContext("trackerTFP::SeedFilter::SeedFilter");
+      throw exception;
+    }
+    seedPairs_.resize(1 << setup_->numLayers());
+    for (int pattern = 0; pattern < (int)seedPairs_.size(); pattern++)
+      for (int layer1 = 0; layer1 < setup_->numLayers(); layer1++)
+        for (int layer2 = layer1 + 1; layer2 < setup_->numLayers(); layer2++)
+          if ((pattern >> layer1 & 1) && (pattern >> layer2 & 1))
+            seedPairs_[pattern].emplace_back(layer1, layer2);
+    const double baseR = dataFormats_->base(Variable::r, Process::mht);
+    const double baseZ = dataFormats_->base(Variable::z, Process::mht);
+    const double baseCot = dataFormats_->base(Variable::cot, Process::sf);
+    const double baseZT = dataFormats_->base(Variable::zT, Process::sf);
+    // no dedicated seed filter windows are configured, the linear regression ones are used
+    residZPS_ = max(1., floor(setup_->lrResidZPS() / baseZ * 2.));
+    residZ2S_ = max(1., floor(setup_->lrResidZ2S() / baseZ * 2.));
+    beamWindowZ_ = floor(setup_->beamWindowZ() / baseZ * 2.);
+    leverZT_ = lround((setup_->chosenRofZ() - setup_->chosenRofPhi()) / baseR * 2.);
+    leverZ0_ = lround(-setup_->chosenRofPhi() / baseR * 2.);
+    // sf cot = sector cot + dz / dr * 2^shiftCot, sf zT = sector zT + (z1 + dz / dr * (lever - r1)) * 2^shiftZT
+    shiftCot_ = DataFormats::exponent(baseZ / baseR / baseCot, "seed cot");
+    shiftZT_ = -1 - DataFormats::exponent(baseZT / baseZ, "seed zT");
+    offsetsCot_.reserve(setup_->numSectorsEta());
+    offsetsZT_.reserve(setup_->numSectorsEta());
+    for (int sectorEta = 0; sectorEta < setup_->numSectorsEta(); sectorEta++) {
+      const double cot = setup_->sectorCot(sectorEta);
+      offsetsCot_.push_back(floor(cot / baseCot + .5));
+      offsetsZT_.push_back(floor(cot * setup_->chosenRofZ() / baseZT + .5));
+    }
+  }
+
+  // drop tracks of previous event, allocated memory is kept
+  void SeedFilter::clear() {
+    for (vector<int>* v : {&channel_, &sectorPhi_, &sectorEta_, &qOverPt_, &phiT_, &begin_, &r_, &z_, &layer_, &ps_})
+      v->clear();
+    frames_.clear();
+  }
+
+  // read in and organize input product
+  void SeedFilter::consume(const TTDTC::Streams& stubs, const TTDTC::Streams& tracks) {
+    clear();
+    const int numChannel = dataFormats_->numChannel(Process::mht);
+    const int offset = region_ * numChannel;
+    const vector<Field>& fields = dataFormats_->fields(Process::mht);
+    for (int channel = 0; channel < numChannel; channel++) {
+      const TTDTC::Stream& stream = stubs[offset + channel];
+      const TTDTC::Stream& streamTracks = tracks[offset + channel];
+      for (auto frame = streamTracks.begin(); frame != streamTracks.end(); frame += DataFormats::numFramesTrack_) {
+        if (frame->first.isNull())
+          continue;
+        const TrackMHT track(frame, dataFormats_);
+        // candidates with too few layers can not form a seed filter track
+        if (__builtin_popcount(track.hitPattern()) < setup_->sfMinLayers())
+          continue;
+        channel_.push_back(channel);
+        sectorPhi_.push_back(track.sectorPhi());
+        sectorEta_.push_back(track.sectorEta());
+        qOverPt_.push_back(track.qOverPt());
+        phiT_.push_back(track.phiT());
+        begin_.push_back(frames_.size());
+        for (int i = track.begin(); i < track.end(); i++) {
+          const TTDTC::Frame& stub = stream[i];
+          const unsigned long long word = stub.second.to_ullong();
+          frames_.push_back(stub);
+          r_.push_back(2 * fields[0].integer(word) + 1);
+          z_.push_back(2 * fields[2].integer(word) + 1);
+          layer_.push_back(fields[3].integer(word));
+          ps_.push_back(setup_->psModule(stub.first));
+        }
+      }
+    }
+    begin_.push_back(frames_.size());
+  }
+
+  // fill output products
+  void SeedFilter::produce(TTDTC::Streams& accepted, TTDTC::Streams& tracks) {
+    const int offset = region_ * dataFormats_->numChannel(Process::sf);
+    for (int track = 0; track < (int)channel_.size(); track++) {
+      int seed1, seed2;
+      const int hitPattern = filter(track, seed1, seed2);
+      if (hitPattern == 0)
+        continue;
+      int cot, zT;
+      seed(seed1, seed2, sectorEta_[track], cot, zT);
+      // sf stubs share the mht stub layout, consistent stubs are forwarded unchanged
+      TTDTC::Stream& stream = accepted[offset + channel_[track]];
+      const int begin = stream.size();
+      for (int stub = begin_[track]; stub < begin_[track + 1]; stub++)
+        if (consistent(stub, seed1, seed2))
+          stream.push_back(frames_[stub]);
+      const TrackSF trackSF(stream[begin].first, dataFormats_, sectorPhi_[track], sectorEta_[track],
+                            qOverPt_[track], phiT_[track], cot, zT, hitPattern, begin, stream.size() - begin);
+      trackSF.put(tracks[offset + channel_[track]]);
+    }
+  }
+
+  // finds seed of given track with most consistent layers, returns its hit layer pattern or 0 if none is found
+  int SeedFilter::filter(int track, int& seed1, int& seed2) const {
+    const int begin = begin_[track];
+    const int end = begin_[track + 1];
+    int patternPS(0);
+    for (int stub = begin; stub < end; stub++)
+      patternPS |= ps_[stub] << layer_[stub];
+    int best(0);
+    int cot, zT;
+    for (const pair<int, int>& layers : seedPairs_[patternPS]) {
+      for (int stub1 = begin; stub1 < end; stub1++) {
+        if (!ps_[stub1] || layer_[stub1] != layers.first)
+          continue;
+        for (int stub2 = begin; stub2 < end; stub2++) {
+          if (!ps_[stub2] || layer_[stub2] != layers.second)
+            continue;
+          if (!seed(stub1, stub2, sectorEta_[track], cot, zT))
+            continue;
+          int pattern(0);
+          for (int stub = begin; stub < end; stub++)
+            if (consistent(stub, stub1, stub2))
+              pattern |= 1 << layer_[stub];
+          // first seed wins ties
+          if (__builtin_popcount(pattern) > __builtin_popcount(best)) {
+            best = pattern;
+            seed1 = stub1;
+            seed2 = stub2;
+          }
+        }
+      }
+    }
+    return __builtin_popcount(best) >= setup_->sfMinLayers() ? best : 0;
+  }
+
+  // digitises seed formed by given stubs, returns false if seed is out of range or misses the beam window
+  bool SeedFilter::seed(int seed1, int seed2, int sectorEta, int& cot, int& zT) const {
+    long long dr = r_[seed2] - r_[seed1];
+    long long dz = z_[seed2] - z_[seed1];
+    if (dr == 0)
+      return false;
+    if (dr < 0) {
+      dr = -dr;
+      dz = -dz;
+    }
+    const long long z1 = z_[seed1];
+    const long long r1 = r_[seed1];
+    // seed z at beam line times dr
+    if (abs(z1 * dr + dz * (leverZ0_ - r1)) > beamWindowZ_ * dr)
+      return false;
+    cot = digitise(offsetsCot_[sectorEta], 0, dz, dr, shiftCot_);
+    zT = digitise(offsetsZT_[sectorEta], 0, z1 * dr + dz * (leverZT_ - r1), dr, shiftZT_);
+    auto inRange = [this](Variable v, int i){ return dataFormats_->format(v, Process::sf).inRange(i); };
+    return inRange(Variable::cot, cot) && inRange(Variable::zT, zT);
+  }
+
+  // true if stub is consistent in r-z with seed formed by given stubs
+  bool SeedFilter::consistent(int stub, int seed1, int seed2) const {
+    long long dr = r_[seed2] - r_[seed1];
+    long long dz = z_[seed2] - z_[seed1];
+    if (dr < 0) {
+      dr = -dr;
+      dz = -dz;
+    }
+    const long long resid = (long long)(z_[stub] - z_[seed1]) * dr - dz * (r_[stub] - r_[seed1]);
+    return abs(resid) <= (ps_[stub] ? residZPS_ : residZ2S_) * dr;
+  }
+
+  // floor(cell * 2^shiftCell + num / den * 2^shiftNum) for den > 0
+  int SeedFilter::digitise(long long cell, int shiftCell, long long num, long long den, int shiftNum) {
+    const int shift = min({0, shiftCell, shiftNum});
+    const long long numerator = cell * den * (1LL << (shiftCell - shift)) + num * (1LL << (shiftNum - shift));
+    return floorDiv(numerator, den * (1LL << -shift));
+  }
+
+} // namespace trackerTFP
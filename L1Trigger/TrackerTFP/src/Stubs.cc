@@ -0,0 +1,249 @@
+#include "L1Trigger/TrackerTFP/interface/Stubs.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <vector>
+#include <string>
+
+using namespace std;
+using namespace trackerDTC;
+
+namespace trackerTFP {
+
+  // mask with bits first to last set
+  static Mask maskRange(int first, int last) {
+    if (last < first)
+      return 0;
+    const int n = last - first + 1;
+    return (n < 64 ? (1ULL << n) - 1 : ~0ULL) << first;
+  }
+
+  // masks are limited to 64 bits
+  static void checkMask(int size, const string& name) {
+    if (size <= 64)
+      return;
+    cms::Exception exception("BadConfiguration");
+    exception << "Number of " << name << " is " << size << " but at most 64 are supported.";
+    exception.addContext("trackerTFP::Stubs");
+    throw exception;
+  }
+
+  StubsPP::StubsPP(const DataFormats* dataFormats) :
+    dataFormats_(dataFormats)
+  {
+    const Setup* setup = dataFormats_->setup();
+    checkMask(setup->numSectors(), "sectors");
+    patternsEta_.reserve(setup->numSectorsEta() + 1);
+    patternsEta_.push_back(0);
+    for (int sectorEta = 0; sectorEta < setup->numSectorsEta(); sectorEta++)
+      patternsEta_.push_back(patternsEta_.back() | 1ULL << (sectorEta * setup->numSectorsPhi()));
+  }
+
+  void StubsPP::emplace_back(const TTDTC::Frame& frame) {
+    const vector<Field>& fields = dataFormats_->fields(Process::pp);
+    const unsigned long long word = frame.second.to_ullong();
+    ttStubRefs_.push_back(frame.first);
+    r_.push_back(fields[0].integer(word));
+    phi_.push_back(fields[1].integer(word));
+    z_.push_back(fields[2].integer(word));
+    layer_.push_back(fields[3].integer(word));
+    qOverPtMin_.push_back(fields[7].integer(word));
+    qOverPtMax_.push_back(fields[8].integer(word));
+    sectorsPhi_.push_back(fields[4].integer(word));
+    sectorEtaMin_.push_back(fields[5].integer(word));
+    sectorEtaMax_.push_back(fields[6].integer(word));
+  }
+
+  void StubsPP::fillSectors() {
+    const int n = size();
+    sectors_.resize(n);
+    const Mask* patternsEta = patternsEta_.data();
+    const Mask* sectorsPhi = sectorsPhi_.data();
+    const int* sectorEtaMin = sectorEtaMin_.data();
+    const int* sectorEtaMax = sectorEtaMax_.data();
+    Mask* sectors = sectors_.data();
+    // sector mask built from phi sector pattern repeated for all eta sectors in range, patterns do not overlap
+#pragma GCC ivdep
+    for (int i = 0; i < n; i++) {
+      const Mask patternEta = patternsEta[sectorEtaMax[i] + 1] - patternsEta[sectorEtaMin[i]];
+      sectors[i] = sectorEtaMin[i] <= sectorEtaMax[i] ? sectorsPhi[i] * patternEta : 0;
+    }
+  }
+
+  void StubsPP::reserve(int n) {
+    ttStubRefs_.reserve(n);
+    r_.reserve(n);
+    phi_.reserve(n);
+    z_.reserve(n);
+    layer_.reserve(n);
+    qOverPtMin_.reserve(n);
+    qOverPtMax_.reserve(n);
+    sectorsPhi_.reserve(n);
+    sectorEtaMin_.reserve(n);
+    sectorEtaMax_.reserve(n);
+    sectors_.reserve(n);
+  }
+
+  void StubsPP::clear() {
+    ttStubRefs_.clear();
+    r_.clear();
+    phi_.clear();
+    z_.clear();
+    layer_.clear();
+    qOverPtMin_.clear();
+    qOverPtMax_.clear();
+    sectorsPhi_.clear();
+    sectorEtaMin_.clear();
+    sectorEtaMax_.clear();
+    sectors_.clear();
+  }
+
+  StubsGP::StubsGP(const DataFormats* dataFormats) :
+    dataFormats_(dataFormats),
+    offsetQoverPt_(dataFormats_->setup()->htNumBinsQoverPt() / 2)
+  {
+    checkMask(dataFormats_->setup()->htNumBinsQoverPt(), "qOverPt bins");
+  }
+
+  void StubsGP::emplace_back(const TTDTC::Frame& frame, int sectorPhi, int sectorEta) {
+    const vector<Field>& fields = dataFormats_->fields(Process::gp);
+    const unsigned long long word = frame.second.to_ullong();
+    ttStubRefs_.push_back(frame.first);
+    r_.push_back(fields[0].integer(word));
+    phi_.push_back(fields[1].integer(word));
+    z_.push_back(fields[2].integer(word));
+    layer_.push_back(fields[3].integer(word));
+    qOverPtMin_.push_back(fields[4].integer(word));
+    qOverPtMax_.push_back(fields[5].integer(word));
+    sectorPhi_.push_back(sectorPhi);
+    sectorEta_.push_back(sectorEta);
+    qOverPtBins_.push_back(maskRange(qOverPtMin_.back() + offsetQoverPt_, qOverPtMax_.back() + offsetQoverPt_));
+  }
+
+  void StubsGP::emplace_back(const StubsPP& stubs, int i, int sectorPhi, int sectorEta) {
+    ttStubRefs_.push_back(stubs.ttStubRef(i));
+    r_.push_back(stubs.r(i));
+    phi_.push_back(dataFormats_->phiGP(stubs.phi(i), sectorPhi));
+    z_.push_back(dataFormats_->zGP(stubs.z(i), stubs.r(i), sectorEta));
+    layer_.push_back(stubs.layer(i));
+    qOverPtMin_.push_back(stubs.qOverPtMin(i));
+    qOverPtMax_.push_back(stubs.qOverPtMax(i));
+    sectorPhi_.push_back(sectorPhi);
+    sectorEta_.push_back(sectorEta);
+    qOverPtBins_.push_back(maskRange(qOverPtMin_.back() + offsetQoverPt_, qOverPtMax_.back() + offsetQoverPt_));
+  }
+
+  void StubsGP::emplace_back(const StubsPP& stubs, const vector<vector<Arrival>>& arrivals) {
+    const int offset = size();
+    const int numSectorsPhi = dataFormats_->setup()->numSectorsPhi();
+    // gather PP stubs
+    for (int sector = 0; sector < (int)arrivals.size(); sector++) {
+      for (const Arrival& arrival : arrivals[sector]) {
+        const int i = arrival.stub_;
+        ttStubRefs_.push_back(stubs.ttStubRef(i));
+        r_.push_back(stubs.r(i));
+        phi_.push_back(stubs.phi(i));
+        z_.push_back(stubs.z(i));
+        layer_.push_back(stubs.layer(i));
+        qOverPtMin_.push_back(stubs.qOverPtMin(i));
+        qOverPtMax_.push_back(stubs.qOverPtMax(i));
+        sectorPhi_.push_back(sector % numSectorsPhi);
+        sectorEta_.push_back(sector / numSectorsPhi);
+        qOverPtBins_.push_back(maskRange(qOverPtMin_.back() + offsetQoverPt_, qOverPtMax_.back() + offsetQoverPt_));
+      }
+    }
+    // sector residuals of all stubs and sectors at once on contiguous columns
+    const int n = size() - offset;
+    dataFormats_->phiGP(phi_.data() + offset, sectorPhi_.data() + offset, n);
+    dataFormats_->zGP(z_.data() + offset, r_.data() + offset, sectorEta_.data() + offset, n);
+  }
+
+  TTDTC::Frame StubsGP::frame(int i) const {
+    const vector<Field>& fields = dataFormats_->fields(Process::gp);
+    unsigned long long word(0);
+    fields[0].attach(r_[i], word);
+    fields[1].attach(phi_[i], word);
+    fields[2].attach(z_[i], word);
+    fields[3].attach(layer_[i], word);
+    fields[4].attach(qOverPtMin_[i], word);
+    fields[5].attach(qOverPtMax_[i], word);
+    return TTDTC::Frame(ttStubRefs_[i], TTDTC::BV(word));
+  }
+
+  void StubsGP::reserve(int n) {
+    ttStubRefs_.reserve(n);
+    r_.reserve(n);
+    phi_.reserve(n);
+    z_.reserve(n);
+    layer_.reserve(n);
+    qOverPtMin_.reserve(n);
+    qOverPtMax_.reserve(n);
+    sectorPhi_.reserve(n);
+    sectorEta_.reserve(n);
+    qOverPtBins_.reserve(n);
+  }
+
+  void StubsGP::clear() {
+    ttStubRefs_.clear();
+    r_.clear();
+    phi_.clear();
+    z_.clear();
+    layer_.clear();
+    qOverPtMin_.clear();
+    qOverPtMax_.clear();
+    sectorPhi_.clear();
+    sectorEta_.clear();
+    qOverPtBins_.clear();
+  }
+
+  StubsLF::StubsLF(const DataFormats* dataFormats) : dataFormats_(dataFormats) {}
+
+  void StubsLF::emplace_back(const StubsGP& stubs, int i, int qOverPt, int phiT) {
+    ttStubRefs_.push_back(stubs.ttStubRef(i));
+    r_.push_back(stubs.r(i));
+    phi_.push_back(dataFormats_->phiLF(stubs.phi(i), stubs.r(i), qOverPt, phiT));
+    z_.push_back(stubs.z(i));
+    layer_.push_back(stubs.layer(i));
+    sectorPhi_.push_back(stubs.sectorPhi(i));
+    sectorEta_.push_back(stubs.sectorEta(i));
+    phiT_.push_back(phiT);
+    qOverPt_.push_back(qOverPt);
+  }
+
+  TTDTC::Frame StubsLF::frame(int i) const {
+    const vector<Field>& fields = dataFormats_->fields(Process::lf);
+    unsigned long long word(0);
+    fields[0].attach(r_[i], word);
+    fields[1].attach(phi_[i], word);
+    fields[2].attach(z_[i], word);
+    fields[3].attach(layer_[i], word);
+    fields[4].attach(sectorPhi_[i], word);
+    fields[5].attach(sectorEta_[i], word);
+    fields[6].attach(phiT_[i], word);
+    return TTDTC::Frame(ttStubRefs_[i], TTDTC::BV(word));
+  }
+
+  void StubsLF::reserve(int n) {
+    ttStubRefs_.reserve(n);
+    r_.reserve(n);
+    phi_.reserve(n);
+    z_.reserve(n);
+    layer_.reserve(n);
+    sectorPhi_.reserve(n);
+    sectorEta_.reserve(n);
+    phiT_.reserve(n);
+    qOverPt_.reserve(n);
+  }
+
+  void StubsLF::clear() {
+    ttStubRefs_.clear();
+    r_.clear();
+    phi_.clear();
+    z_.clear();
+    layer_.clear();
+    sectorPhi_.clear();
+    sectorEta_.clear();
+    phiT_.clear();
+    qOverPt_.clear();
+  }
+
+}  // namespace trackerTFP
@@ -0,0 +1,218 @@
+#include "FWCore/Framework/interface/one/EDAnalyzer.h"
+#include "FWCore/Framework/interface/Run.h"
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/MakerMacros.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "L1Trigger/TrackerDTC/interface/Setup.h"
+#include "L1Trigger/TrackerTFP/interface/DataFormats.h"
+
+#include <vector>
+#include <cmath>
+#include <string>
+#include <sstream>
+
+using namespace std;
+using namespace edm;
+using namespace trackerDTC;
+
+namespace trackerTFP {
+
+  /*! \class  trackerTFP::AnalyzerDataFormats
+   *  \brief  Class to check the integer domain stub transformations of DataFormats against the former floating
+   *          point calculations over the full digitised stub domain. The only tolerated differences are exact ties
+   *          at bin boundaries, which the floating point calculation resolves by rounding noise.
+   *  \author Thomas Schuh, development Maziar Ghorbani
+   *  \date   2020, September
+   */
+  class AnalyzerDataFormats : public one::EDAnalyzer<one::WatchRuns> {
+  public:
+    AnalyzerDataFormats(const ParameterSet& iConfig);
+    void beginJob() override {}
+    void beginRun(const Run& iEvent, const EventSetup& iSetup) override;
+    void analyze(const Event& iEvent, const EventSetup& iSetup) override {}
+    void endRun(const Run& iEvent, const EventSetup& iSetup) override {}
+    void endJob() override;
+
+  private:
+    // sector phi and sector z residuals of all pp phi, z and r in all sectors
+    void checkGP();
+    // hough transform and track phi residuals of all gp phi and r in all qOverPt bins
+    void checkLF();
+    // throws unless d / base lies at a bin boundary
+    void check(bool equal, double d, double base, const string& what, int& ties) const;
+    // throws LogicError for a difference of x lsb
+    void mismatch(const string& what, double x) const;
+
+    // DataFormats token
+    ESGetToken<DataFormats, DataFormatsRcd> esGetTokenDataFormats_;
+    // helper class to extract structured data from TTDTC::Frames
+    const DataFormats* dataFormats_;
+    // stores, calculates and provides run-time constants
+    const Setup* setup_;
+    // number of checked values and of tolerated ties per transformation
+    long long numGP_, numLF_;
+    int tiesPhiGP_, tiesZGP_, tiesPhiT_, tiesTwoCandidates_, tiesPhiLF_;
+
+    // printout
+    stringstream log_;
+  };
+
+  AnalyzerDataFormats::AnalyzerDataFormats(const ParameterSet& iConfig) :
+    dataFormats_(nullptr),
+    setup_(nullptr),
+    numGP_(0),
+    numLF_(0),
+    tiesPhiGP_(0),
+    tiesZGP_(0),
+    tiesPhiT_(0),
+    tiesTwoCandidates_(0),
+    tiesPhiLF_(0)
+  {
+    // book ES product
+    esGetTokenDataFormats_ = esConsumes<DataFormats, DataFormatsRcd, Transition::BeginRun>();
+  }
+
+  void AnalyzerDataFormats::beginRun(const Run& iEvent, const EventSetup& iSetup) {
+    // helper class to extract structured data from TTDTC::Frames
+    dataFormats_ = &iSetup.getData(esGetTokenDataFormats_);
+    setup_ = dataFormats_->setup();
+    checkGP();
+    checkLF();
+  }
+
+  void AnalyzerDataFormats::endJob() {
+    log_ << "                 DATA FORMATS  SUMMARY                       " << endl;
+    log_ << "checked gp stubs = " << numGP_ << ", ties in phi = " << tiesPhiGP_ << ", ties in z = " << tiesZGP_
+         << endl;
+    log_ << "checked lf stubs = " << numLF_ << ", ties in phiT = " << tiesPhiT_
+         << ", ties in second candidate = " << tiesTwoCandidates_ << ", ties in phi = " << tiesPhiLF_ << endl;
+    log_ << "=============================================================";
+    LogPrint("L1Trigger/TrackerTFP") << log_.str();
+  }
+
+  // sector phi and sector z residuals of all pp phi, z and r in all sectors
+  void AnalyzerDataFormats::checkGP() {
+    const DataFormat& phiPP = dataFormats_->format(Variable::phi, Process::pp);
+    const DataFormat& zPP = dataFormats_->format(Variable::z, Process::pp);
+    const DataFormat& rPP = dataFormats_->format(Variable::r, Process::pp);
+    const DataFormat& phiGP = dataFormats_->format(Variable::phi, Process::gp);
+    const DataFormat& zGP = dataFormats_->format(Variable::z, Process::gp);
+    // signed integer domain of a format
+    auto first = [](const DataFormat& f) { return f.twos() ? -(1 << (f.width() - 1)) : 0; };
+    auto last = [first](const DataFormat& f) { return first(f) + (1 << f.width()); };
+    for (int sectorPhi = 0; sectorPhi < setup_->numSectorsPhi(); sectorPhi++) {
+      vector<int> phis, sectorPhis;
+      for (int phi = first(phiPP); phi < last(phiPP); phi++) {
+        // former StubGP: phi -= (sectorPhi - .5) * baseSector
+        const double d = phiPP.floating(phi) - (sectorPhi - .5) * setup_->baseSector();
+        const int integer = dataFormats_->phiGP(phi, sectorPhi);
+        check(integer == phiGP.integer(d), d, phiGP.base(), "gp phi", tiesPhiGP_);
+        phis.push_back(phi);
+        sectorPhis.push_back(sectorPhi);
+      }
+      // batch version has to agree bit by bit with single stub version
+      dataFormats_->phiGP(phis.data(), sectorPhis.data(), phis.size());
+      for (int phi = first(phiPP), i = 0; phi < last(phiPP); phi++, i++)
+        if (phis[i] != dataFormats_->phiGP(phi, sectorPhi))
+          mismatch("batched gp phi", 0.);
+      numGP_ += phis.size();
+    }
+    for (int sectorEta = 0; sectorEta < setup_->numSectorsEta(); sectorEta++) {
+      const double cot = setup_->sectorCot(sectorEta);
+      for (int r = first(rPP); r < last(rPP); r++) {
+        vector<int> zs, rs, sectorEtas;
+        for (int z = first(zPP); z < last(zPP); z++) {
+          // former StubGP: z -= (r + chosenRofPhi) * sectorCot
+          const double d = zPP.floating(z) - (rPP.floating(r) + setup_->chosenRofPhi()) * cot;
+          const int integer = dataFormats_->zGP(z, r, sectorEta);
+          check(integer == zGP.integer(d), d, zGP.base(), "gp z", tiesZGP_);
+          zs.push_back(z);
+          rs.push_back(r);
+          sectorEtas.push_back(sectorEta);
+        }
+        // batch version has to agree bit by bit with single stub version
+        dataFormats_->zGP(zs.data(), rs.data(), sectorEtas.data(), zs.size());
+        for (int z = first(zPP), i = 0; z < last(zPP); z++, i++)
+          if (zs[i] != dataFormats_->zGP(z, r, sectorEta))
+            mismatch("batched gp z", 0.);
+        numGP_ += zs.size();
+      }
+    }
+  }
+
+  // hough transform and track phi residuals of all gp phi and r in all qOverPt bins
+  void AnalyzerDataFormats::checkLF() {
+    const DataFormat& phiGP = dataFormats_->format(Variable::phi, Process::gp);
+    const DataFormat& rGP = dataFormats_->format(Variable::r, Process::gp);
+    const DataFormat& qOverPtLF = dataFormats_->format(Variable::qOverPt, Process::lf);
+    const DataFormat& phiTLF = dataFormats_->format(Variable::phiT, Process::lf);
+    const DataFormat& phiLF = dataFormats_->format(Variable::phi, Process::lf);
+    auto first = [](const DataFormat& f) { return f.twos() ? -(1 << (f.width() - 1)) : 0; };
+    auto last = [first](const DataFormat& f) { return first(f) + (1 << f.width()); };
+    const int numPhis = 1 << phiGP.width();
+    vector<int> phis(numPhis), rs(numPhis), majors(numPhis), minors(numPhis);
+    for (int binQoverPt = 0; binQoverPt < setup_->htNumBinsQoverPt(); binQoverPt++) {
+      const int qOverPt = qOverPtLF.toSigned(binQoverPt);
+      for (int r = first(rGP); r < last(rGP); r++) {
+        for (int phi = first(phiGP), i = 0; phi < last(phiGP); phi++, i++) {
+          phis[i] = phi;
+          rs[i] = r;
+        }
+        dataFormats_->phiT(phis.data(), rs.data(), numPhis, qOverPt, majors.data(), minors.data());
+        for (int phi = first(phiGP), i = 0; phi < last(phiGP); phi++, i++) {
+          // former LinearFitter::fillIn
+          const double phiT = phiGP.floating(phi) + qOverPtLF.floating(qOverPt) * rGP.floating(r);
+          const int major = phiTLF.integer(phiT);
+          const double chi = phiT - phiTLF.floating(major);
+          const double width = abs(rGP.floating(r) * qOverPtLF.base()) + 2. * abs(chi);
+          const bool twoCandidates = width >= phiTLF.base();
+          int majorInt, minorInt;
+          const bool twoCandidatesInt = dataFormats_->phiT(phi, r, qOverPt, majorInt, minorInt);
+          check(majorInt == major, phiT, phiTLF.base(), "lf major phiT", tiesPhiT_);
+          check(twoCandidatesInt == twoCandidates, width - phiTLF.base(), phiTLF.base(), "lf second candidate",
+                tiesTwoCandidates_);
+          // batch version has to agree bit by bit with single stub version
+          if (majors[i] != majorInt || minors[i] != (twoCandidatesInt ? minorInt : majorInt))
+            mismatch("batched lf phiT", 0.);
+          // former StubLF: phi += qOverPt * r - phiT, for all phiT bins this stub is assigned to
+          for (int bin : {majorInt, minorInt}) {
+            if (bin == minorInt && !twoCandidatesInt)
+              continue;
+            const double d = phiGP.floating(phi) + qOverPtLF.floating(qOverPt) * rGP.floating(r) -
+                             phiTLF.floating(bin);
+            const int integer = dataFormats_->phiLF(phi, r, qOverPt, bin);
+            check(integer == phiLF.integer(d), d, phiLF.base(), "lf phi", tiesPhiLF_);
+          }
+        }
+        numLF_ += numPhis;
+      }
+    }
+  }
+
+  // throws unless d / base lies at a bin boundary
+  void AnalyzerDataFormats::check(bool equal, double d, double base, const string& what, int& ties) const {
+    if (equal)
+      return;
+    const double x = d / base;
+    if (abs(x - round(x)) < 1.e-6) {
+      ties++;
+      return;
+    }
+    mismatch(what, x);
+  }
+
+  // throws LogicError for a difference of x lsb
+  void AnalyzerDataFormats::mismatch(const string& what, double x) const {
+    cms::Exception exception("LogicError");
+    exception << "Integer domain " << what << " differs from floating point calculation at " << x << " lsb.";
+    exception.addContext("trackerTFP::AnalyzerDataFormats::mismatch");
+    throw exception;
+  }
+
+}  // namespace trackerTFP
+
+DEFINE_FWK_MODULE(trackerTFP::AnalyzerDataFormats);
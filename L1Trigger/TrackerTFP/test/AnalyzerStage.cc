@@ -0,0 +1,359 @@
+#include "FWCore/Framework/interface/one/EDAnalyzer.h"
+#include "FWCore/Framework/interface/Run.h"
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/MakerMacros.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/ServiceRegistry/interface/Service.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/Utilities/interface/EDGetToken.h"
+#include "FWCore/Utilities/interface/InputTag.h"
+#include "FWCore/Utilities/interface/Exception.h"
+#include "CommonTools/UtilAlgos/interface/TFileService.h"
+#include "DataFormats/Common/interface/Handle.h"
+
+#include "SimTracker/TrackTriggerAssociation/interface/StubAssociation.h"
+#include "L1Trigger/TrackerDTC/interface/Setup.h"
+#include "L1Trigger/TrackerTFP/interface/DataFormats.h"
+
+#include <TProfile.h>
+#include <TH1F.h>
+
+#include <array>
+#include <vector>
+#include <set>
+#include <cmath>
+#include <string>
+#include <iomanip>
+#include <sstream>
+#include <iterator>
+#include <algorithm>
+#include <tuple>
+#include <utility>
+#include <type_traits>
+
+using namespace std;
+using namespace edm;
+using namespace trackerDTC;
+using namespace tt;
+
+namespace trackerTFP {
+
+  /*! \class  trackerTFP::AnalyzerStage
+   *  \brief  Class to analyze stubs and tracks of a track finding stage with track stream (LR, MHT, SF, KF or DR),
+   *          checks that track frames round-trip
+   *  \author Thomas Schuh, development Maziar Ghorbani
+   *  \date   2020, September
+   */
+  template<typename TrackType, Process p>
+  class AnalyzerStage : public one::EDAnalyzer<one::WatchRuns, one::SharedResources> {
+  public:
+    AnalyzerStage(const ParameterSet& iConfig);
+    void beginJob() override {}
+    void beginRun(const Run& iEvent, const EventSetup& iSetup) override;
+    void analyze(const Event& iEvent, const EventSetup& iSetup) override;
+    void endRun(const Run& iEvent, const EventSetup& iSetup) override {}
+    void endJob() override;
+
+  private:
+    // name of stage, used for labels and directories
+    static constexpr array<const char*, +Process::end> names_ = {{
+      "FE", "DTC", "PP", "GP", "LF", "LR", "MHT", "SF", "KF", "DR"
+    }};
+    // encodes and decodes tracks with extreme field values, throws if any field does not survive
+    void checkRoundTrip() const;
+    // throws if given track is not encoded as given frames
+    void checkEncoding(const TrackType& track, TTDTC::Stream::const_iterator frame) const;
+    // associates tracks with TPs and counts matched tracks
+    void associate(const vector<vector<TTStubRef>>& tracks,
+                   const StubAssociation* ass,
+                   set<TPPtr>& tps,
+                   int& sum) const;
+
+    // ED input token of stubs
+    EDGetTokenT<TTDTC::Streams> edGetTokenAccepted_;
+    // ED input token of tracks
+    EDGetTokenT<TTDTC::Streams> edGetTokenTracks_;
+    // ED input token of TTStubRef to selected TPPtr association
+    EDGetTokenT<StubAssociation> edGetTokenSelection_;
+    // ED input token of TTStubRef to recontructable TPPtr association
+    EDGetTokenT<StubAssociation> edGetTokenReconstructable_;
+    // Setup token
+    ESGetToken<Setup, SetupRcd> esGetTokenSetup_;
+    // DataFormats token
+    ESGetToken<DataFormats, DataFormatsRcd> esGetTokenDataFormats_;
+    // stores, calculates and provides run-time constants
+    const Setup* setup_;
+    // helper class to extract structured data from TTDTC::Frames
+    const DataFormats* dataFormats_;
+    // enables analyze of TPs
+    bool useMCTruth_;
+    //
+    int nEvents_;
+
+    // Histograms
+
+    TProfile* prof_;
+    TProfile* profChannel_;
+    TH1F* hisChannel_;
+    TH1F* hisStubs_;
+
+    // printout
+    stringstream log_;
+  };
+
+  template<typename TrackType, Process p>
+  AnalyzerStage<TrackType, p>::AnalyzerStage(const ParameterSet& iConfig) :
+    useMCTruth_(iConfig.getParameter<bool>("UseMCTruth")),
+    nEvents_(0)
+  {
+    usesResource("TFileService");
+    // book in- and output ED products
+    const string& label = iConfig.getParameter<string>("Label" + string(names_[+p]));
+    const string& branchAccepted = iConfig.getParameter<string>("BranchAccepted");
+    const string& branchTracks = iConfig.getParameter<string>("BranchTracks");
+    edGetTokenAccepted_ = consumes<TTDTC::Streams>(InputTag(label, branchAccepted));
+    edGetTokenTracks_ = consumes<TTDTC::Streams>(InputTag(label, branchTracks));
+    if (useMCTruth_) {
+      const auto& inputTagSelecttion = iConfig.getParameter<InputTag>("InputTagSelection");
+      const auto& inputTagReconstructable = iConfig.getParameter<InputTag>("InputTagReconstructable");
+      edGetTokenSelection_ = consumes<StubAssociation>(inputTagSelecttion);
+      edGetTokenReconstructable_ = consumes<StubAssociation>(inputTagReconstructable);
+    }
+    // book ES products
+    esGetTokenSetup_ = esConsumes<Setup, SetupRcd, Transition::BeginRun>();
+    esGetTokenDataFormats_ = esConsumes<DataFormats, DataFormatsRcd, Transition::BeginRun>();
+    // initial ES products
+    setup_ = nullptr;
+    dataFormats_ = nullptr;
+    // log config
+    log_.setf(ios::fixed, ios::floatfield);
+    log_.precision(4);
+  }
+
+  template<typename TrackType, Process p>
+  void AnalyzerStage<TrackType, p>::beginRun(const Run& iEvent, const EventSetup& iSetup) {
+    // helper class to store configurations
+    setup_ = &iSetup.getData(esGetTokenSetup_);
+    // helper class to extract structured data from TTDTC::Frames
+    dataFormats_ = &iSetup.getData(esGetTokenDataFormats_);
+    checkRoundTrip();
+    // book histograms
+    Service<TFileService> fs;
+    TFileDirectory dir;
+    dir = fs->mkdir(names_[+p]);
+    prof_ = dir.make<TProfile>("Counts", ";", 8, 0.5, 8.5);
+    prof_->GetXaxis()->SetBinLabel(1, "Stubs");
+    prof_->GetXaxis()->SetBinLabel(2, "Tracks");
+    prof_->GetXaxis()->SetBinLabel(3, "Matched Tracks");
+    prof_->GetXaxis()->SetBinLabel(4, "All Tracks");
+    prof_->GetXaxis()->SetBinLabel(5, "Found TPs");
+    prof_->GetXaxis()->SetBinLabel(6, "Found selected TPs");
+    prof_->GetXaxis()->SetBinLabel(7, "All TPs");
+    prof_->GetXaxis()->SetBinLabel(8, "Stubs per Track");
+    // binQoverPt occupancy in tracks
+    constexpr int maxOcc = 60;
+    constexpr int maxStubs = 20;
+    const int numChannel = dataFormats_->numChannel(p);
+    hisChannel_ = dir.make<TH1F>("His binQoverPt Occupancy", ";", maxOcc, -.5, maxOcc - .5);
+    profChannel_ = dir.make<TProfile>("Prof binQoverPt Occupancy", ";", numChannel, -.5, numChannel - .5);
+    hisStubs_ = dir.make<TH1F>("His Stubs per Track", ";", maxStubs, -.5, maxStubs - .5);
+  }
+
+  template<typename TrackType, Process p>
+  void AnalyzerStage<TrackType, p>::analyze(const Event& iEvent, const EventSetup& iSetup) {
+    // read in stage products
+    Handle<TTDTC::Streams> handleAccepted;
+    iEvent.getByToken<TTDTC::Streams>(edGetTokenAccepted_, handleAccepted);
+    Handle<TTDTC::Streams> handleTracks;
+    iEvent.getByToken<TTDTC::Streams>(edGetTokenTracks_, handleTracks);
+    // read in MCTruth
+    const StubAssociation* selection = nullptr;
+    const StubAssociation* reconstructable = nullptr;
+    if (useMCTruth_) {
+      Handle<StubAssociation> handleSelection;
+      iEvent.getByToken<StubAssociation>(edGetTokenSelection_, handleSelection);
+      selection = handleSelection.product();
+      prof_->Fill(7, selection->numTPs());
+      Handle<StubAssociation> handleReconstructable;
+      iEvent.getByToken<StubAssociation>(edGetTokenReconstructable_, handleReconstructable);
+      reconstructable = handleReconstructable.product();
+    }
+    // analyze stage products and associate found tracks with reconstrucable TrackingParticles
+    set<TPPtr> tpPtrs;
+    set<TPPtr> tpPtrsSelection;
+    int allMatched(0);
+    int allTracks(0);
+    const int numChannel = dataFormats_->numChannel(p);
+    for (int region = 0; region < setup_->numRegions(); region++) {
+      int nStubs(0);
+      int nTracks(0);
+      for (int channel = 0; channel < numChannel; channel++) {
+        const int index = region * numChannel + channel;
+        const TTDTC::Stream& accepted = handleAccepted->at(index);
+        const TTDTC::Stream& streamTracks = handleTracks->at(index);
+        vector<vector<TTStubRef>> tracks;
+        tracks.reserve(streamTracks.size() / DataFormats::numFramesTrack_);
+        for (auto frame = streamTracks.begin(); frame != streamTracks.end(); frame += DataFormats::numFramesTrack_) {
+          if (frame->first.isNull())
+            continue;
+          const TrackType track(frame, dataFormats_);
+          checkEncoding(track, frame);
+          if (track.end() > (int)accepted.size()) {
+            cms::Exception exception("LogicError");
+            exception << names_[+p] << " track addresses stubs up to " << track.end() << " but channel " << index
+                      << " holds " << accepted.size() << " stubs.";
+            exception.addContext("trackerTFP::AnalyzerStage::analyze");
+            throw exception;
+          }
+          vector<TTStubRef> ttStubRefs;
+          ttStubRefs.reserve(track.size());
+          for (int stub = track.begin(); stub < track.end(); stub++)
+            ttStubRefs.push_back(accepted[stub].first);
+          hisStubs_->Fill(track.size());
+          prof_->Fill(8, track.size());
+          tracks.push_back(move(ttStubRefs));
+        }
+        hisChannel_->Fill(tracks.size());
+        profChannel_->Fill(channel, tracks.size());
+        nStubs += accepted.size();
+        nTracks += tracks.size();
+        allTracks += tracks.size();
+        if (!useMCTruth_)
+          continue;
+        int tmp(0);
+        associate(tracks, selection, tpPtrsSelection, tmp);
+        associate(tracks, reconstructable, tpPtrs, allMatched);
+      }
+      prof_->Fill(1, nStubs);
+      prof_->Fill(2, nTracks);
+    }
+    prof_->Fill(3, allMatched);
+    prof_->Fill(4, allTracks);
+    prof_->Fill(5, tpPtrs.size());
+    prof_->Fill(6, tpPtrsSelection.size());
+    nEvents_++;
+  }
+
+  template<typename TrackType, Process p>
+  void AnalyzerStage<TrackType, p>::endJob() {
+    // printout stage summary
+    const double numStubs = prof_->GetBinContent(1);
+    const double numTracks = prof_->GetBinContent(2);
+    const double numTracksMatched = prof_->GetBinContent(3);
+    const double totalTracks = prof_->GetBinContent(4);
+    const double numTPsAll = prof_->GetBinContent(5);
+    const double numTPsEff = prof_->GetBinContent(6);
+    const double totalTPs = prof_->GetBinContent(7);
+    const double numStubsTrack = prof_->GetBinContent(8);
+    const double errStubs = prof_->GetBinError(1);
+    const double errTracks = prof_->GetBinError(2);
+    const double errStubsTrack = prof_->GetBinError(8);
+    const double fracFake = (totalTracks - numTracksMatched) / totalTracks;
+    const double fracDup = (numTracksMatched - numTPsAll) / totalTracks;
+    const double eff = numTPsEff / totalTPs;
+    const double errEff = sqrt(eff * (1. - eff) / totalTPs / nEvents_);
+    const vector<double> nums = {numStubs, numTracks, numStubsTrack};
+    const vector<double> errs = {errStubs, errTracks, errStubsTrack};
+    const int wNums = ceil(log10(*max_element(nums.begin(), nums.end()))) + 5;
+    const int wErrs = ceil(log10(*max_element(errs.begin(), errs.end()))) + 5;
+    log_ << "                        " << setw(3) << names_[+p] << "  SUMMARY                         " << endl;
+    log_ << "number of stubs       per TFP = " << setw(wNums) << numStubs << " +- " << setw(wErrs) << errStubs << endl;
+    log_ << "number of tracks      per TFP = " << setw(wNums) << numTracks << " +- " << setw(wErrs) << errTracks
+         << endl;
+    log_ << "number of stubs     per track = " << setw(wNums) << numStubsTrack << " +- " << setw(wErrs) << errStubsTrack
+         << endl;
+    log_ << "          tracking efficiency = " << setw(wNums) << eff << " +- " << setw(wErrs) << errEff << endl;
+    log_ << "                    fake rate = " << setw(wNums) << fracFake << endl;
+    log_ << "               duplicate rate = " << setw(wNums) << fracDup << endl;
+    log_ << "=============================================================";
+    LogPrint("L1Trigger/TrackerTFP") << log_.str();
+  }
+
+  // encodes and decodes tracks with extreme field values, throws if any field does not survive
+  template<typename TrackType, Process p>
+  void AnalyzerStage<TrackType, p>::checkRoundTrip() const {
+    // given bit pattern truncated to given width, read as two's complement if signed
+    auto pattern = [](unsigned long long bits, int width, bool twos) {
+      const long long value = bits & ((1ULL << width) - 1);
+      return (int)(twos && (value >> (width - 1)) ? value - (1LL << width) : value);
+    };
+    // bits of a field of given width: all cleared, all set, smallest value, largest value and alternating patterns
+    constexpr int numTests = 6;
+    auto bits = [](int test, int width, bool twos) {
+      const unsigned long long sign = twos ? 1ULL << (width - 1) : 0;
+      const vector<unsigned long long> tests = {0, ~0ULL, sign, ~sign, 0x5555555555555555ULL, 0xaaaaaaaaaaaaaaaaULL};
+      return tests[test];
+    };
+    const int widthStubs = DataFormats::widthStubs_;
+    for (int test = 0; test < numTests; test++) {
+      const int hitPattern = pattern(bits(test, setup_->numLayers(), false), setup_->numLayers(), false);
+      const int begin = pattern(bits(test, widthStubs, false), widthStubs, false);
+      const int size = pattern(~bits(test, widthStubs, false), widthStubs, false);
+      decay_t<decltype(declval<TrackType>().data())> data;
+      auto variable = dataFormats_->tracks(p).begin();
+      auto fill = [this, test, &bits, &pattern, &variable](int& value) {
+        const DataFormat& format = dataFormats_->format(*variable++, p);
+        value = pattern(bits(test, format.width(), format.twos()), format.width(), format.twos());
+      };
+      apply([&fill](auto&... values){ (fill(values), ...); }, data);
+      auto encode = [this, hitPattern, begin, size](auto... values) {
+        return TrackType(TTStubRef(), dataFormats_, values..., hitPattern, begin, size);
+      };
+      TTDTC::Stream stream;
+      apply(encode, data).put(stream);
+      const TrackType track(stream.begin(), dataFormats_);
+      if (track.data() != data || track.hitPattern() != hitPattern || track.begin() != begin ||
+          track.size() != size) {
+        cms::Exception exception("LogicError");
+        exception << names_[+p] << " track fields do not survive encoding into " << stream.size() << " frames.";
+        exception.addContext("trackerTFP::AnalyzerStage::checkRoundTrip");
+        throw exception;
+      }
+    }
+  }
+
+  // throws if given track is not encoded as given frames
+  template<typename TrackType, Process p>
+  void AnalyzerStage<TrackType, p>::checkEncoding(const TrackType& track, TTDTC::Stream::const_iterator frame) const {
+    auto encode = [this, &track](auto... values) {
+      return TrackType(track.ttStubRef(), dataFormats_, values..., track.hitPattern(), track.begin(), track.size());
+    };
+    TTDTC::Stream stream;
+    apply(encode, track.data()).put(stream);
+    if (!equal(stream.begin(), stream.end(), frame)) {
+      cms::Exception exception("LogicError");
+      exception << names_[+p] << " track frames differ from the encoding of their decoded fields.";
+      exception.addContext("trackerTFP::AnalyzerStage::checkEncoding");
+      throw exception;
+    }
+  }
+
+  // associates tracks with TPs and counts matched tracks
+  template<typename TrackType, Process p>
+  void AnalyzerStage<TrackType, p>::associate(const vector<vector<TTStubRef>>& tracks,
+                                          const StubAssociation* ass,
+                                          set<TPPtr>& tps,
+                                          int& sum) const {
+    for (const vector<TTStubRef>& ttStubRefs : tracks) {
+      const vector<TPPtr>& tpPtrs = ass->associate(ttStubRefs);
+      if (tpPtrs.empty())
+        continue;
+      sum++;
+      copy(tpPtrs.begin(), tpPtrs.end(), inserter(tps, tps.begin()));
+    }
+  }
+
+  typedef AnalyzerStage<TrackLR, Process::lr> AnalyzerLR;
+  typedef AnalyzerStage<TrackMHT, Process::mht> AnalyzerMHT;
+  typedef AnalyzerStage<TrackSF, Process::sf> AnalyzerSF;
+  typedef AnalyzerStage<TrackKF, Process::kf> AnalyzerKF;
+  typedef AnalyzerStage<TrackDR, Process::dr> AnalyzerDR;
+
+}  // namespace trackerTFP
+
+DEFINE_FWK_MODULE(trackerTFP::AnalyzerLR);
+DEFINE_FWK_MODULE(trackerTFP::AnalyzerMHT);
+DEFINE_FWK_MODULE(trackerTFP::AnalyzerSF);
+DEFINE_FWK_MODULE(trackerTFP::AnalyzerKF);
+DEFINE_FWK_MODULE(trackerTFP::AnalyzerDR);
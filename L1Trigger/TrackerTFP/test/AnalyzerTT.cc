@@ -0,0 +1,219 @@
+#include "FWCore/Framework/interface/one/EDAnalyzer.h"
+#include "FWCore/Framework/interface/Run.h"
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/MakerMacros.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/ServiceRegistry/interface/Service.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+#include "FWCore/Utilities/interface/EDGetToken.h"
+#include "FWCore/Utilities/interface/InputTag.h"
+#include "CommonTools/UtilAlgos/interface/TFileService.h"
+#include "DataFormats/Common/interface/Handle.h"
+#include "DataFormats/L1TrackTrigger/interface/TTTypes.h"
+
+#include "SimTracker/TrackTriggerAssociation/interface/StubAssociation.h"
+#include "L1Trigger/TrackerDTC/interface/Setup.h"
+
+#include <TProfile.h>
+#include <TH1F.h>
+
+#include <vector>
+#include <set>
+#include <cmath>
+#include <string>
+#include <iomanip>
+#include <sstream>
+#include <iterator>
+#include <algorithm>
+
+using namespace std;
+using namespace edm;
+using namespace trackerDTC;
+using namespace tt;
+
+namespace trackerTFP {
+
+  /*! \class  trackerTFP::AnalyzerTT
+   *  \brief  Class to analyze TTTracks found by the TFP, compares track phi0 with phi of associated TPs
+   *  \author Thomas Schuh, development Maziar Ghorbani
+   *  \date   2020, September
+   */
+  class AnalyzerTT : public one::EDAnalyzer<one::WatchRuns, one::SharedResources> {
+  public:
+    AnalyzerTT(const ParameterSet& iConfig);
+    void beginJob() override {}
+    void beginRun(const Run& iEvent, const EventSetup& iSetup) override;
+    void analyze(const Event& iEvent, const EventSetup& iSetup) override;
+    void endRun(const Run& iEvent, const EventSetup& iSetup) override {}
+    void endJob() override;
+
+  private:
+    typedef TTTrack<Ref_Phase2TrackerDigi_> TTTrackType;
+    // associates tracks with TPs and counts matched tracks
+    void associate(const vector<TTTrackType>& ttTracks, const StubAssociation* ass, set<TPPtr>& tps, int& sum) const;
+
+    // ED input token of TTTracks
+    EDGetTokenT<vector<TTTrackType>> edGetToken_;
+    // ED input token of TTStubRef to selected TPPtr association
+    EDGetTokenT<StubAssociation> edGetTokenSelection_;
+    // ED input token of TTStubRef to recontructable TPPtr association
+    EDGetTokenT<StubAssociation> edGetTokenReconstructable_;
+    // Setup token
+    ESGetToken<Setup, SetupRcd> esGetTokenSetup_;
+    // stores, calculates and provides run-time constants
+    const Setup* setup_;
+    // enables analyze of TPs
+    bool useMCTruth_;
+    //
+    int nEvents_;
+
+    // Histograms
+
+    TProfile* prof_;
+    TProfile* profRegion_;
+    TH1F* hisPhi0_;
+
+    // printout
+    stringstream log_;
+  };
+
+  AnalyzerTT::AnalyzerTT(const ParameterSet& iConfig) :
+    useMCTruth_(iConfig.getParameter<bool>("UseMCTruth")),
+    nEvents_(0)
+  {
+    usesResource("TFileService");
+    // book in- and output ED products
+    const string& label = iConfig.getParameter<string>("LabelTT");
+    const string& branch = iConfig.getParameter<string>("BranchTracks");
+    edGetToken_ = consumes<vector<TTTrackType>>(InputTag(label, branch));
+    if (useMCTruth_) {
+      const auto& inputTagSelecttion = iConfig.getParameter<InputTag>("InputTagSelection");
+      const auto& inputTagReconstructable = iConfig.getParameter<InputTag>("InputTagReconstructable");
+      edGetTokenSelection_ = consumes<StubAssociation>(inputTagSelecttion);
+      edGetTokenReconstructable_ = consumes<StubAssociation>(inputTagReconstructable);
+    }
+    // book ES products
+    esGetTokenSetup_ = esConsumes<Setup, SetupRcd, Transition::BeginRun>();
+    // initial ES products
+    setup_ = nullptr;
+    // log config
+    log_.setf(ios::fixed, ios::floatfield);
+    log_.precision(4);
+  }
+
+  void AnalyzerTT::beginRun(const Run& iEvent, const EventSetup& iSetup) {
+    // helper class to store configurations
+    setup_ = &iSetup.getData(esGetTokenSetup_);
+    // book histograms
+    Service<TFileService> fs;
+    TFileDirectory dir;
+    dir = fs->mkdir("TT");
+    prof_ = dir.make<TProfile>("Counts", ";", 7, 0.5, 7.5);
+    prof_->GetXaxis()->SetBinLabel(1, "Tracks");
+    prof_->GetXaxis()->SetBinLabel(2, "Matched Tracks");
+    prof_->GetXaxis()->SetBinLabel(3, "Found TPs");
+    prof_->GetXaxis()->SetBinLabel(4, "Found selected TPs");
+    prof_->GetXaxis()->SetBinLabel(5, "All TPs");
+    prof_->GetXaxis()->SetBinLabel(6, "phi0 - TP phi");
+    prof_->GetXaxis()->SetBinLabel(7, "|phi0 - TP phi|");
+    // tracks per region and phi0 residual of matched tracks, range covers a few sectors
+    const int numRegions = setup_->numRegions();
+    const double maxPhi0 = 2. * setup_->baseSector();
+    profRegion_ = dir.make<TProfile>("Prof Region Occupancy", ";", numRegions, -.5, numRegions - .5);
+    hisPhi0_ = dir.make<TH1F>("His phi0 - TP phi", ";", 200, -maxPhi0, maxPhi0);
+  }
+
+  void AnalyzerTT::analyze(const Event& iEvent, const EventSetup& iSetup) {
+    // read in TTTracks
+    Handle<vector<TTTrackType>> handle;
+    iEvent.getByToken<vector<TTTrackType>>(edGetToken_, handle);
+    const vector<TTTrackType>& ttTracks = *handle.product();
+    vector<int> numTracks(setup_->numRegions(), 0);
+    for (const TTTrackType& ttTrack : ttTracks)
+      numTracks[ttTrack.phiSector()]++;
+    for (int region = 0; region < setup_->numRegions(); region++)
+      profRegion_->Fill(region, numTracks[region]);
+    prof_->Fill(1, ttTracks.size());
+    nEvents_++;
+    if (!useMCTruth_)
+      return;
+    // read in MCTruth
+    Handle<StubAssociation> handleSelection;
+    iEvent.getByToken<StubAssociation>(edGetTokenSelection_, handleSelection);
+    const StubAssociation* selection = handleSelection.product();
+    prof_->Fill(5, selection->numTPs());
+    Handle<StubAssociation> handleReconstructable;
+    iEvent.getByToken<StubAssociation>(edGetTokenReconstructable_, handleReconstructable);
+    const StubAssociation* reconstructable = handleReconstructable.product();
+    // associate found tracks with reconstrucable TrackingParticles
+    set<TPPtr> tpPtrs;
+    set<TPPtr> tpPtrsSelection;
+    int allMatched(0);
+    int tmp(0);
+    associate(ttTracks, selection, tpPtrsSelection, tmp);
+    associate(ttTracks, reconstructable, tpPtrs, allMatched);
+    prof_->Fill(2, allMatched);
+    prof_->Fill(3, tpPtrs.size());
+    prof_->Fill(4, tpPtrsSelection.size());
+    // phi0 of tracks matched to reconstructable TPs
+    for (const TTTrackType& ttTrack : ttTracks) {
+      const vector<TPPtr>& tps = reconstructable->associate(ttTrack.getStubRefs());
+      if (tps.empty())
+        continue;
+      const double dPhi0 = deltaPhi(ttTrack.phi() - tps.front()->phi());
+      hisPhi0_->Fill(dPhi0);
+      prof_->Fill(6, dPhi0);
+      prof_->Fill(7, abs(dPhi0));
+    }
+  }
+
+  void AnalyzerTT::endJob() {
+    // printout TT summary
+    const double numTracks = prof_->GetBinContent(1);
+    const double numTracksMatched = prof_->GetBinContent(2);
+    const double numTPsAll = prof_->GetBinContent(3);
+    const double numTPsEff = prof_->GetBinContent(4);
+    const double totalTPs = prof_->GetBinContent(5);
+    const double meanPhi0 = prof_->GetBinContent(6);
+    const double absPhi0 = prof_->GetBinContent(7);
+    const double errTracks = prof_->GetBinError(1);
+    const double errMeanPhi0 = prof_->GetBinError(6);
+    const double errAbsPhi0 = prof_->GetBinError(7);
+    const double fracFake = (numTracks - numTracksMatched) / numTracks;
+    const double fracDup = (numTracksMatched - numTPsAll) / numTracks;
+    const double eff = numTPsEff / totalTPs;
+    const double errEff = sqrt(eff * (1. - eff) / totalTPs / nEvents_);
+    const int wNums = ceil(log10(max(numTracks, 1.))) + 5;
+    const int wErrs = ceil(log10(max(errTracks, 1.))) + 5;
+    log_ << "                         TT  SUMMARY                         " << endl;
+    log_ << "number of tracks    per event = " << setw(wNums) << numTracks << " +- " << setw(wErrs) << errTracks
+         << endl;
+    log_ << "          tracking efficiency = " << setw(wNums) << eff << " +- " << setw(wErrs) << errEff << endl;
+    log_ << "                    fake rate = " << setw(wNums) << fracFake << endl;
+    log_ << "               duplicate rate = " << setw(wNums) << fracDup << endl;
+    log_ << "         mean phi0 - TP phi   = " << setw(wNums) << meanPhi0 << " +- " << setw(wErrs) << errMeanPhi0
+         << endl;
+    log_ << "         mean |phi0 - TP phi| = " << setw(wNums) << absPhi0 << " +- " << setw(wErrs) << errAbsPhi0
+         << endl;
+    log_ << "=============================================================";
+    LogPrint("L1Trigger/TrackerTFP") << log_.str();
+  }
+
+  // associates tracks with TPs and counts matched tracks
+  void AnalyzerTT::associate(const vector<TTTrackType>& ttTracks,
+                             const StubAssociation* ass,
+                             set<TPPtr>& tps,
+                             int& sum) const {
+    for (const TTTrackType& ttTrack : ttTracks) {
+      const vector<TPPtr>& tpPtrs = ass->associate(ttTrack.getStubRefs());
+      if (tpPtrs.empty())
+        continue;
+      sum++;
+      copy(tpPtrs.begin(), tpPtrs.end(), inserter(tps, tps.begin()));
+    }
+  }
+
+}  // namespace trackerTFP
+
+DEFINE_FWK_MODULE(trackerTFP::AnalyzerTT);
@@ -0,0 +1,29 @@
+################################################################################################
+# Checks the integer domain stub transformations against the former floating point calculations
+# To run execute do
+# cmsRun L1Trigger/TrackerTFP/test/dataformats_cfg.py
+#################################################################################################
+
+import FWCore.ParameterSet.Config as cms
+
+process = cms.Process( "Test" )
+process.load( 'Configuration.Geometry.GeometryExtended2026D49Reco_cff' )
+process.load( 'Configuration.Geometry.GeometryExtended2026D49_cff' )
+process.load( 'Configuration.StandardSequences.MagneticField_cff' )
+process.load( 'Configuration.StandardSequences.FrontierConditions_GlobalTag_cff' )
+process.load( 'Configuration.StandardSequences.L1TrackTrigger_cff' )
+
+from Configuration.AlCa.GlobalTag import GlobalTag
+process.GlobalTag = GlobalTag( process.GlobalTag, 'auto:phase2_realistic', '' )
+
+#--- Load code that produces tfp Stubs
+process.load( 'L1Trigger.TrackerTFP.Producer_cff' )
+#--- Load code that analyzes tfp Stubs
+process.load( 'L1Trigger.TrackerTFP.Analyzer_cff' )
+
+process.dataFormats = cms.Path( process.TrackerTFPAnalyzerDataFormats )
+process.schedule = cms.Schedule( process.dataFormats )
+
+process.options = cms.untracked.PSet( wantSummary = cms.untracked.bool(False) )
+process.maxEvents = cms.untracked.PSet( input = cms.untracked.int32(1) )
+process.source = cms.Source( "EmptySource" )
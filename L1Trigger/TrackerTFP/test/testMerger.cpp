@@ -0,0 +1,317 @@
+#include "L1Trigger/TrackerTFP/interface/Merger.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <utility>
+#include <random>
+#include <iterator>
+#include <algorithm>
+
+using namespace std;
+using namespace trackerTFP;
+
+namespace {
+
+  int failures(0);
+
+  void check(bool condition, const string& what) {
+    if (condition)
+      return;
+    cerr << "testMerger: FAILED " << what << endl;
+    failures++;
+  }
+
+  // pops front of fifo, -1 marks pops from empty fifos like the nullptr of the former StubGP* fifos
+  int pop_front(deque<int>& ts) {
+    int t = -1;
+    if (!ts.empty()) {
+      t = ts.front();
+      ts.pop_front();
+    }
+    return t;
+  }
+
+  // truncates accepted stream as done by GeometricProcessor and LinearFitter before trackerTFP::Merger existed
+  void truncate(bool enableTruncation, int numFrames, vector<int>& accepted, vector<int>& lost) {
+    if (enableTruncation && (int)accepted.size() > numFrames) {
+      const auto limit = next(accepted.begin(), numFrames);
+      copy_if(limit, accepted.end(), back_inserter(lost), [](int stub) { return stub != -1; });
+      accepted.erase(limit, accepted.end());
+    }
+    // gaps and pops from empty fifos never reached the products
+    accepted.erase(remove(accepted.begin(), accepted.end(), -1), accepted.end());
+    lost.erase(remove(lost.begin(), lost.end(), -1), lost.end());
+  }
+
+  // merge loop of GeometricProcessor::produce before trackerTFP::Merger existed, serves as reference
+  void referenceGP(int numChannel,
+                   int depth,
+                   bool enableTruncation,
+                   int numFrames,
+                   const vector<Arrival>& arrivals,
+                   vector<int>& accepted,
+                   vector<int>& lost) {
+    // dense input streams, one entry per tick, gaps marked with -1
+    vector<deque<int>> inputs(numChannel);
+    for (const Arrival& arrival : arrivals) {
+      deque<int>& input = inputs[arrival.channel_];
+      input.resize(arrival.tick_, -1);
+      input.push_back(arrival.stub_);
+    }
+    vector<deque<int>> stacks(numChannel);
+    auto empty = [](const deque<int>& stubs) { return stubs.empty(); };
+    // each while trip describes one clock tick, one stub in per channel and one stub out per tick
+    while (!all_of(inputs.begin(), inputs.end(), empty) || !all_of(stacks.begin(), stacks.end(), empty)) {
+      for (int channel = 0; channel < numChannel; channel++) {
+        deque<int>& stack = stacks[channel];
+        const int stub = pop_front(inputs[channel]);
+        if (stub != -1) {
+          if (enableTruncation && (int)stack.size() == depth - 1)
+            lost.push_back(pop_front(stack));
+          stack.push_back(stub);
+        }
+      }
+      bool nothingToRoute(true);
+      for (int channel = numChannel - 1; channel >= 0; channel--) {
+        const int stub = pop_front(stacks[channel]);
+        if (stub != -1) {
+          nothingToRoute = false;
+          accepted.push_back(stub);
+          break;
+        }
+      }
+      if (nothingToRoute)
+        accepted.push_back(-1);
+    }
+    truncate(enableTruncation, numFrames, accepted, lost);
+  }
+
+  // LF candidate of one GP stub, major and minor phiT bin either inside or outside of range
+  struct Candidates {
+    bool major_;
+    bool minor_;
+  };
+
+  // merge loop of LinearFitter::fillIn before trackerTFP::Merger existed, serves as reference
+  void referenceLF(int depth,
+                   bool enableTruncation,
+                   int numFrames,
+                   const vector<Arrival>& arrivals,
+                   const vector<Candidates>& candidates,
+                   vector<int>& accepted,
+                   vector<int>& lost) {
+    // dense input stream, one entry per tick, gaps marked with -1
+    deque<int> input;
+    for (const Arrival& arrival : arrivals) {
+      input.resize(arrival.tick_, -1);
+      input.push_back(arrival.stub_);
+    }
+    // LF stub ids are given in order of creation
+    int stubLF(0);
+    deque<int> stack;
+    // each while trip describes one clock tick, one stub in and one stub out per tick
+    while (!input.empty() || !stack.empty()) {
+      int major = -1;
+      const int stubGP = pop_front(input);
+      if (stubGP != -1) {
+        if (candidates[stubGP].major_)
+          major = stubLF++;
+        if (candidates[stubGP].minor_) {
+          if (enableTruncation && (int)stack.size() == depth - 1)
+            lost.push_back(pop_front(stack));
+          stack.push_back(stubLF++);
+        }
+      }
+      // take a minor stub if no major stub available
+      accepted.push_back(major != -1 ? major : pop_front(stack));
+    }
+    truncate(enableTruncation, numFrames, accepted, lost);
+  }
+
+  // feeds stub ids straight into the merger
+  void feed(int channel, int stub, Merger& merger, vector<int>& lost) { merger.push(channel, stub, lost); }
+
+  // random time ordered arrivals, at most one stub per channel and tick
+  vector<Arrival> arrivals(mt19937& gen, int numChannel, int numTicks, double occupancy) {
+    bernoulli_distribution hit(occupancy);
+    vector<Arrival> arrivals;
+    for (int tick = 0; tick < numTicks; tick++)
+      for (int channel = 0; channel < numChannel; channel++)
+        if (hit(gen))
+          arrivals.push_back({tick, channel, (int)arrivals.size()});
+    return arrivals;
+  }
+
+  // run() reproduces the GeometricProcessor reference accepted and lost streams for random configurations
+  void testReferenceGP() {
+    mt19937 gen(20201);
+    uniform_int_distribution<int> channels(1, 18);
+    uniform_int_distribution<int> depths(1, 8);
+    uniform_int_distribution<int> frames(1, 64);
+    uniform_real_distribution<double> occupancies(.05, .9);
+    for (int trial = 0; trial < 2000; trial++) {
+      const int numChannel = channels(gen);
+      const int depth = depths(gen);
+      const bool enableTruncation = trial % 2 == 0;
+      const int numFrames = frames(gen);
+      // gaps between bursts exercise the skipping of idle ticks, which the reference clocks through
+      vector<Arrival> input = arrivals(gen, numChannel, numFrames, occupancies(gen));
+      for (Arrival& arrival : input)
+        arrival.tick_ += (arrival.tick_ / 8) * 8;
+      vector<int> accepted, lost, acceptedRef, lostRef;
+      referenceGP(numChannel, depth, enableTruncation, numFrames, input, acceptedRef, lostRef);
+      Merger merger(numChannel, depth, enableTruncation, numFrames);
+      // a second event on the same merger has to start from empty fifos
+      for (int event = 0; event < 2; event++) {
+        accepted.clear();
+        lost.clear();
+        merger.run(input, feed, accepted, lost);
+        check(accepted == acceptedRef, "accepted stream matches reference");
+        check(lost == lostRef, "lost stream matches reference");
+        check((int)(accepted.size() + lost.size()) == (int)input.size(), "every stub is either accepted or lost");
+      }
+    }
+  }
+
+  // run() with a major/minor feed as used by LinearFitter reproduces the LinearFitter reference
+  void testReferenceLF() {
+    mt19937 gen(20202);
+    uniform_int_distribution<int> depths(1, 8);
+    uniform_int_distribution<int> frames(1, 64);
+    uniform_real_distribution<double> occupancies(.05, 1.);
+    bernoulli_distribution inRange(.8);
+    bernoulli_distribution twoCandidates(.5);
+    for (int trial = 0; trial < 2000; trial++) {
+      const int depth = depths(gen);
+      const bool enableTruncation = trial % 2 == 0;
+      const int numFrames = frames(gen);
+      vector<Arrival> input = arrivals(gen, 1, 2 * numFrames, occupancies(gen));
+      for (Arrival& arrival : input)
+        arrival.tick_ += (arrival.tick_ / 8) * 8;
+      vector<Candidates> candidates;
+      candidates.reserve(input.size());
+      for (int stub = 0; stub < (int)input.size(); stub++)
+        candidates.push_back({inRange(gen), twoCandidates(gen) && inRange(gen)});
+      vector<int> accepted, lost, acceptedRef, lostRef;
+      referenceLF(depth, enableTruncation, numFrames, input, candidates, acceptedRef, lostRef);
+      Merger merger(2, depth, enableTruncation, numFrames);
+      for (int event = 0; event < 2; event++) {
+        accepted.clear();
+        lost.clear();
+        int stubLF(0);
+        auto feed = [&candidates, &stubLF](int, int stubGP, Merger& merger, vector<int>& lost) {
+          if (candidates[stubGP].major_)
+            merger.push(1, stubLF++, lost);
+          if (candidates[stubGP].minor_)
+            merger.push(0, stubLF++, lost);
+        };
+        merger.run(input, feed, accepted, lost);
+        check(accepted == acceptedRef, "LF accepted stream matches reference");
+        check(lost == lostRef, "LF lost stream matches reference");
+        check((int)(accepted.size() + lost.size()) == stubLF, "every LF stub is either accepted or lost");
+      }
+    }
+  }
+
+  // fifos keep their order while the ring buffers grow with a wrapped head
+  void testGrowth() {
+    Merger merger(3, 2, false, 0);
+    vector<int> lost;
+    deque<int> expected;
+    int stub(0);
+    // move head away from slot 0 so that growth has to unwrap the ring
+    merger.push(1, stub++, lost);
+    merger.push(1, stub++, lost);
+    check(merger.pop(1) == 0 && merger.pop(1) == 1, "fifo order before growth");
+    merger.push(1, stub++, lost);
+    expected.push_back(stub - 1);
+    for (int i = 0; i < 100; i++) {
+      merger.push(1, stub, lost);
+      expected.push_back(stub++);
+      if (i % 3 == 0) {
+        check(merger.pop(1) == expected.front(), "fifo order while growing");
+        expected.pop_front();
+      }
+    }
+    check(lost.empty(), "no overflow without truncation");
+    check(merger.size(1) == (int)expected.size(), "fifo size after growth");
+    check(merger.maxOccupancy(1) >= merger.size(1), "max occupancy after growth");
+    check(merger.empty(0) && merger.empty(2), "other fifos untouched by growth");
+    while (!expected.empty()) {
+      check(merger.pop() == expected.front(), "fifo order after growth");
+      expected.pop_front();
+    }
+    check(merger.empty() && merger.pop() == -1, "merger drained");
+  }
+
+  // highest occupied channel wins, including the 64th channel
+  void testArbitration() {
+    Merger merger(64, 4, true, 100);
+    vector<int> lost;
+    for (int channel : {0, 5, 63, 31, 32})
+      merger.push(channel, channel, lost);
+    for (int channel : {63, 32, 31, 5, 0})
+      check(merger.pop() == channel, "arbitration picks highest occupied channel");
+    check(merger.empty() && merger.pop() == -1, "empty merger returns -1");
+    bool thrown(false);
+    try {
+      Merger tooMany(65, 4, true, 100);
+    } catch (const cms::Exception&) {
+      thrown = true;
+    }
+    check(thrown, "more than 64 channels are rejected");
+  }
+
+  // a full fifo holds depth - 1 stubs, the oldest stub is lost on overflow
+  void testOverflow() {
+    Merger merger(2, 3, true, 100);
+    vector<int> lost;
+    for (int stub = 0; stub < 5; stub++)
+      merger.push(0, stub, lost);
+    check(lost == vector<int>({0, 1, 2}), "oldest stubs lost on overflow");
+    check(merger.size(0) == 2 && merger.numOverflows() == 3, "fifo holds depth - 1 stubs");
+    check(merger.pop() == 3 && merger.pop() == 4, "remaining stubs in order");
+    // depth 1 never drops a stub, like the reference which popped from an empty fifo
+    Merger shallow(1, 1, true, 100);
+    lost.clear();
+    shallow.push(0, 0, lost);
+    shallow.push(0, 1, lost);
+    check(lost.empty() && shallow.size(0) == 2, "depth 1 fifo does not overflow");
+    merger.resetStatistics();
+    check(merger.numOverflows() == 0 && merger.maxOccupancy(0) == 0, "statistics reset");
+  }
+
+  // stubs leaving at or after numFrames are lost if truncation is enabled
+  void testTruncation() {
+    const vector<Arrival> input = {{0, 0, 0}, {0, 1, 1}, {0, 2, 2}, {1, 0, 3}, {5, 1, 4}};
+    vector<int> accepted, lost;
+    Merger merger(3, 8, true, 3);
+    merger.run(input, feed, accepted, lost);
+    check(accepted == vector<int>({2, 1, 0}), "stubs leaving before numFrames accepted");
+    check(lost == vector<int>({3, 4}), "stubs leaving after numFrames truncated");
+    check(merger.numTruncated() == 2, "truncation counted");
+    Merger untruncated(3, 8, false, 3);
+    accepted.clear();
+    lost.clear();
+    untruncated.run(input, feed, accepted, lost);
+    check(accepted == vector<int>({2, 1, 0, 3, 4}) && lost.empty(), "nothing truncated if disabled");
+  }
+
+}  // namespace
+
+int main() {
+  testReferenceGP();
+  testReferenceLF();
+  testGrowth();
+  testArbitration();
+  testOverflow();
+  testTruncation();
+  if (failures > 0) {
+    cerr << "testMerger: " << failures << " checks failed" << endl;
+    return 1;
+  }
+  cout << "testMerger: all checks passed" << endl;
+  return 0;
+}
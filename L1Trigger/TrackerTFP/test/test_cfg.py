@@ -35,7 +35,13 @@ process.mc = cms.Sequence( process.StubAssociator )
 process.dtc = cms.Sequence( process.TrackerDTCProducer + process.TrackerDTCAnalyzer )
 process.gp = cms.Sequence( process.TrackerTFPProducerGP + process.TrackerTFPAnalyzerGP )
 process.lf = cms.Sequence( process.TrackerTFPProducerLF + process.TrackerTFPAnalyzerLF )
-process.tt = cms.Path( process.mc + process.dtc + process.gp + process.lf )
+process.lr = cms.Sequence( process.TrackerTFPProducerLR + process.TrackerTFPAnalyzerLR )
+process.mht = cms.Sequence( process.TrackerTFPProducerMHT + process.TrackerTFPAnalyzerMHT )
+process.sf = cms.Sequence( process.TrackerTFPProducerSF + process.TrackerTFPAnalyzerSF )
+process.kf = cms.Sequence( process.TrackerTFPProducerKF + process.TrackerTFPAnalyzerKF )
+process.dr = cms.Sequence( process.TrackerTFPProducerDR + process.TrackerTFPAnalyzerDR )
+process.ttTracks = cms.Sequence( process.TrackerTFPProducerTT + process.TrackerTFPAnalyzerTT )
+process.tt = cms.Path( process.mc + process.dtc + process.gp + process.lf + process.lr + process.mht + process.sf + process.kf + process.dr + process.ttTracks )
 process.schedule = cms.Schedule( process.tt )
 
 # create options
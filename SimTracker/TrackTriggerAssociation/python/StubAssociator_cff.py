@@ -1,6 +1,6 @@
 import FWCore.ParameterSet.Config as cms
 
-from L1Trigger.TrackerDTC.ProducerES_cff import TrackTriggerSetup
+from L1Trigger.TrackerDTC.ProducerES_cff import TrackTriggerSetup, TrackTriggerSetupGeometry
 from SimTracker.TrackTriggerAssociation.StubAssociator_cfi import StubAssociator_params
 
 StubAssociator = cms.EDProducer('tt::StubAssociator', StubAssociator_params)
\ No newline at end of file